@@ -7,22 +7,37 @@ uniform bool enable_alpha;
 uniform bool enable_fog;
 uniform vec2 fog_delta;
 uniform float fog_distance;
+uniform float fog_fade_in;
 uniform vec3 fog_color;
 
 varying vec3 v_pos;
 varying vec4 v_color;
 varying vec2 v_texcoord;
+varying vec2 v_tile_origin;
+varying vec2 v_tile_offset;
+varying float v_tiled;
 
 void main() {
 	vec4 tex_color = vec4(1.0);
 
-	if(enable_texture)
-		tex_color = texture2D(tex, v_texcoord);
+	if(enable_texture) {
+		vec2 texcoord = v_texcoord;
+
+		if(v_tiled > 0.5)
+			texcoord = (v_tile_origin + mod(v_tile_offset, 16.0)) / 256.0;
+
+		tex_color = texture2D(tex, texcoord);
+	}
 
 	float v_fog = 0.0;
 
-	if(enable_fog)
-		v_fog = clamp((length(fog_delta + v_pos.xz) - (fog_distance - 9.0)) / 8.0, 0.0, 1.0);
+	if(enable_fog) {
+		float dist = length(fog_delta + v_pos.xz);
+		v_fog = clamp((dist - (fog_distance - 9.0)) / 8.0, 0.0, 1.0);
+
+		if(fog_fade_in > 0.0)
+			v_fog = max(v_fog, clamp(1.0 - (dist - fog_fade_in) / (fog_fade_in * 0.5), 0.0, 1.0));
+	}
 
 	vec4 frag = v_color * tex_color;
 	gl_FragColor = vec4(mix(frag.rgb, fog_color, v_fog), frag.a);
@@ -3,6 +3,7 @@
 uniform mat4 mv;
 uniform mat4 proj;
 uniform mat4 texm;
+uniform vec2 vertex_scale;
 
 uniform bool enable_lighting;
 uniform float lighting[256];
@@ -15,6 +16,9 @@ attribute vec2 a_light;
 varying vec3 v_pos;
 varying vec4 v_color;
 varying vec2 v_texcoord;
+varying vec2 v_tile_origin;
+varying vec2 v_tile_offset;
+varying float v_tiled;
 
 void main() {
 	if(enable_lighting) {
@@ -23,7 +27,18 @@ void main() {
 		v_color = a_color;
 	}
 
-	v_pos = a_pos;
-	v_texcoord = (texm * vec4(a_texcoord, 0.0, 1.0)).xy;
-	gl_Position = proj * mv  * vec4(a_pos, 1.0);
+	vec3 pos = a_pos * vertex_scale.x;
+	vec2 texcoord = a_texcoord * vertex_scale.y;
+
+	v_pos = pos;
+	v_texcoord = (texm * vec4(texcoord, 0.0, 1.0)).xy;
+
+	// repeating texture inside one atlas tile, see displaylist_texcoord_repeat
+	vec2 tile_coord = texcoord * 256.0;
+	vec2 tile = floor(tile_coord / 512.0);
+	v_tiled = tile_coord.x >= 512.0 ? 1.0 : 0.0;
+	v_tile_origin = (tile - 1.0) * 18.0 + 3.0;
+	v_tile_offset = tile_coord - tile * 512.0 - 128.0;
+
+	gl_Position = proj * mv  * vec4(pos, 1.0);
 }
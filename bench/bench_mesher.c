@@ -0,0 +1,405 @@
+/*
+	Copyright (c) 2025 Lunna5
+
+	This file is part of CavEX.
+
+	CavEX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	CavEX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with CavEX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Meshes columns of a beta region file without a window or GL context and
+ * prints throughput numbers as JSON.
+
+	usage: cavex_bench_mesher <world dir> [columns] [region x] [region z]
+							  [threads]
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "block/blocks.h"
+#include "chunk.h"
+#include "chunk_mesher.h"
+#include "entity/entity.h"
+#include "game/game_state.h"
+#include "network/region_archive.h"
+#include "network/server_world.h"
+#include "parson/parson.h"
+#include "platform/thread.h"
+#include "platform/time.h"
+#include "world.h"
+
+struct bench_job {
+	struct chunk* chunk;
+	struct chunk_pin pin;
+	float build_time;
+	struct chunk_mesher_stats stats;
+};
+
+struct bench_run {
+	struct bench_job* jobs;
+	size_t length;
+	size_t next;
+	struct thread_mutex lock;
+};
+
+static size_t bench_load_region(struct world* w, const char* world_dir,
+								w_coord_t rx, w_coord_t rz, size_t columns,
+								float* ingest_time) {
+	assert(w && world_dir && ingest_time);
+
+	string_t name;
+	string_init_set_str(name, world_dir);
+
+	struct region_archive ra;
+	if(!region_archive_create(&ra, name, rx, rz, WORLD_DIM_OVERWORLD)) {
+		string_clear(name);
+		return 0;
+	}
+
+	size_t loaded = 0;
+
+	// squares growing from the region corner keep the loaded area compact
+	for(int size = 1; size <= REGION_SIZE && loaded < columns; size++) {
+		for(int k = 0; k < size * 2 - 1 && loaded < columns; k++) {
+			int x = (k < size) ? k : size - 1;
+			int z = (k < size) ? size - 1 : k - size;
+			w_coord_t cx = rx * REGION_SIZE + x;
+			w_coord_t cz = rz * REGION_SIZE + z;
+
+			bool exists;
+			struct server_chunk sc;
+
+			if(!region_archive_contains(&ra, cx, cz, &exists) || !exists
+			   || !region_archive_get_blocks(&ra, cx, cz, &sc))
+				continue;
+
+			ptime_t start = time_get();
+			world_load_column(w, cx, cz, sc.ids, sc.metadata, sc.lighting_sky,
+							  sc.lighting_torch);
+			*ingest_time += time_diff_s(start, time_get());
+			loaded++;
+
+			free(sc.ids);
+			free(sc.metadata);
+			free(sc.lighting_sky);
+			free(sc.lighting_torch);
+			free(sc.heightmap);
+		}
+	}
+
+	region_archive_destroy(&ra);
+	string_clear(name);
+	return loaded;
+}
+
+static void* bench_worker(void* user) {
+	struct bench_run* run = user;
+
+	while(1) {
+		tmutex_lock(&run->lock);
+		size_t index = run->next++;
+		tmutex_unlock(&run->lock);
+
+		if(index >= run->length)
+			break;
+
+		struct bench_job* job = run->jobs + index;
+		ptime_t start = time_get();
+		struct block_data* snapshot
+			= malloc((CHUNK_SIZE + 2) * (CHUNK_SIZE + 2) * (CHUNK_SIZE + 2)
+					 * sizeof(struct block_data));
+		assert(snapshot);
+		chunk_pin_snapshot(&job->pin, snapshot);
+		chunk_mesher_build_snapshot(job->chunk, snapshot, &job->stats);
+		job->build_time = time_diff_s(start, time_get());
+	}
+
+	return NULL;
+}
+
+static int bench_compare_time(const void* a, const void* b) {
+	float ta = ((const struct bench_job*)a)->build_time;
+	float tb = ((const struct bench_job*)b)->build_time;
+	return (ta > tb) - (ta < tb);
+}
+
+static JSON_Value* bench_run(struct bench_job* jobs, size_t length,
+							 size_t threads) {
+	assert(jobs && threads > 0);
+
+	// pinned on the main thread as in chunk_mesher_send(), copied by workers
+	ptime_t queue_start = time_get();
+
+	for(size_t k = 0; k < length; k++)
+		chunk_pin(jobs[k].chunk, &jobs[k].pin);
+
+	float queue_time = time_diff_s(queue_start, time_get());
+
+	struct bench_run run = (struct bench_run) {
+		.jobs = jobs,
+		.length = length,
+		.next = 0,
+	};
+
+	tmutex_init(&run.lock);
+
+	struct thread workers[threads];
+	ptime_t start = time_get();
+
+	for(size_t k = 0; k < threads; k++)
+		thread_create(workers + k, bench_worker, &run, 4);
+
+	for(size_t k = 0; k < threads; k++)
+		thread_join(workers + k);
+
+	float elapsed = time_diff_s(start, time_get());
+	tmutex_destroy(&run.lock);
+
+	for(size_t k = 0; k < length; k++)
+		chunk_unpin(&jobs[k].pin);
+
+	size_t vertices = 0, bytes = 0, saved = 0;
+
+	for(size_t k = 0; k < length; k++) {
+		vertices += jobs[k].stats.vertices;
+		bytes += jobs[k].stats.bytes;
+		saved += jobs[k].stats.saved;
+	}
+
+	qsort(jobs, length, sizeof(struct bench_job), bench_compare_time);
+
+	JSON_Value* res = json_value_init_object();
+	JSON_Object* obj = json_object(res);
+	json_object_set_number(obj, "threads", threads);
+	json_object_set_number(obj, "chunks_per_second",
+						   elapsed > 0.0F ? length / elapsed : 0.0);
+	json_object_set_number(obj, "queue_us_per_chunk",
+						   length ? queue_time * 1e6 / length : 0.0);
+	json_object_set_number(obj, "vertices_per_chunk",
+						   length ? (double)vertices / length : 0.0);
+	json_object_set_number(obj, "bytes_per_chunk",
+						   length ? (double)bytes / length : 0.0);
+	json_object_set_number(obj, "saved_bytes_per_chunk",
+						   length ? (double)saved / length : 0.0);
+	json_object_set_number(obj, "build_us_p50",
+						   length ? jobs[length / 2].build_time * 1e6 : 0.0);
+	json_object_set_number(
+		obj, "build_us_p99",
+		length ? jobs[length * 99 / 100].build_time * 1e6 : 0.0);
+
+	return res;
+}
+
+#define BENCH_LOOKUPS (1 << 22)
+
+// random section lookups in and around the loaded area, through the dict
+// alone and through world_get_section()
+static void bench_lookups(struct world* w, JSON_Object* obj) {
+	assert(w && obj);
+
+	w_coord_t min[2] = {INT32_MAX, INT32_MAX};
+	w_coord_t max[2] = {INT32_MIN, INT32_MIN};
+
+	dict_wsection_it_t it;
+	dict_wsection_it(it, w->sections);
+
+	while(!dict_wsection_end_p(it)) {
+		int64_t id = dict_wsection_ref(it)->key;
+		w_coord_t pos[2] = {(int32_t)(id & 0xFFFFFFFF), (int32_t)(id >> 32)};
+
+		for(int k = 0; k < 2; k++) {
+			min[k] = (pos[k] - 1 < min[k]) ? pos[k] - 1 : min[k];
+			max[k] = (pos[k] + 1 > max[k]) ? pos[k] + 1 : max[k];
+		}
+
+		dict_wsection_next(it);
+	}
+
+	w_coord_t width = max[0] - min[0] + 1;
+	w_coord_t depth = max[1] - min[1] + 1;
+
+	for(int mode = 0; mode < 2; mode++) {
+		uint32_t rand = 1;
+		size_t found = 0;
+		ptime_t start = time_get();
+
+		for(size_t k = 0; k < BENCH_LOOKUPS; k++) {
+			rand = rand * 1664525 + 1013904223;
+			w_coord_t x = min[0] + (rand >> 8) % width;
+			w_coord_t z = min[1] + (rand >> 20) % depth;
+
+			found += (mode == 0) ?
+				dict_wsection_get(w->sections, SECTION_TO_ID(x, z)) != NULL :
+				world_get_section(w, x, z) != NULL;
+		}
+
+		float duration = time_diff_s(start, time_get());
+		json_object_dotset_number(obj,
+								  mode == 0 ? "lookups_per_second.dict" :
+											  "lookups_per_second.ring",
+								  BENCH_LOOKUPS / duration);
+		json_object_dotset_number(obj,
+								  mode == 0 ? "lookups_found.dict" :
+											  "lookups_found.ring",
+								  found);
+	}
+}
+
+#define BENCH_MOVES (1 << 18)
+
+// player sized boxes dropped onto the terrain or pushed sideways, the same
+// collision test entity_try_move() runs each tick
+static void bench_collisions(struct bench_job* jobs, size_t length,
+							 JSON_Object* obj) {
+	assert(jobs && obj);
+
+	if(!length)
+		return;
+
+	struct entity e;
+	entity_default_init(&e, false, &gstate.world);
+
+	struct AABB bbox;
+	aabb_setsize(&bbox, 0.6F, 1.8F, 0.6F);
+
+	uint32_t rand = 1;
+	size_t hits = 0;
+	ptime_t start = time_get();
+
+	for(size_t k = 0; k < BENCH_MOVES; k++) {
+		rand = rand * 1664525 + 1013904223;
+		struct chunk* c = jobs[(rand >> 8) % length].chunk;
+		w_coord_t x = c->x + (rand >> 4) % CHUNK_SIZE;
+		w_coord_t z = c->z + (rand >> 12) % CHUNK_SIZE;
+
+		// resting entities stay within 0.01 above the ground
+		vec3 from = {x + 0.1F, world_get_height(&gstate.world, x, z) + 0.005F,
+					 z + 0.1F};
+		vec3 to;
+		glm_vec3_copy(from, to);
+		to[k % 3] += (k % 3 == 1) ? -0.08F : 0.5F;
+
+		float threshold;
+		hits += entity_intersection_threshold(&e, &bbox, from, to, &threshold);
+	}
+
+	float duration = time_diff_s(start, time_get());
+	json_object_set_number(obj, "collision_ns_per_move",
+						   duration * 1e9F / BENCH_MOVES);
+	json_object_set_number(obj, "collision_hits", hits);
+}
+
+int main(int argc, char** argv) {
+	if(argc < 2) {
+		fprintf(stderr,
+				"usage: %s <world dir> [columns] [region x] [region z] "
+				"[threads]\n",
+				argv[0]);
+		return 1;
+	}
+
+	size_t columns = (argc > 2) ? strtoul(argv[2], NULL, 10) : 64;
+	w_coord_t rx = (argc > 3) ? atoi(argv[3]) : 0;
+	w_coord_t rz = (argc > 4) ? atoi(argv[4]) : 0;
+	size_t threads = (argc > 5) ? strtoul(argv[5], NULL, 10) :
+								  thread_hardware_concurrency();
+
+	blocks_init();
+	chunk_pool_init(0);
+	world_create(&gstate.world);
+
+	float ingest_time = 0.0F;
+	size_t loaded = bench_load_region(&gstate.world, argv[1], rx, rz, columns,
+									  &ingest_time);
+
+	if(!loaded) {
+		fprintf(stderr, "no columns found in region %i %i of %s\n", rx, rz,
+				argv[1]);
+		return 1;
+	}
+
+	size_t capacity = loaded * COLUMN_HEIGHT;
+	struct bench_job* jobs = malloc(capacity * sizeof(struct bench_job));
+	assert(jobs);
+
+	size_t length = 0, skipped = 0, storage = 0, stored = 0;
+
+	dict_wsection_it_t it;
+	dict_wsection_it(it, gstate.world.sections);
+
+	while(!dict_wsection_end_p(it)) {
+		struct world_section* s = &dict_wsection_ref(it)->value;
+
+		for(size_t k = 0; k < COLUMN_HEIGHT; k++) {
+			struct chunk* c = s->column[k];
+
+			if(c) {
+				storage += chunk_storage_bytes(c);
+				stored++;
+			}
+
+			// the game never sends these to a worker either
+			if(!c || !c->non_air || chunk_enclosed(c)) {
+				skipped++;
+				continue;
+			}
+
+			jobs[length++] = (struct bench_job) {.chunk = c};
+		}
+
+		dict_wsection_next(it);
+	}
+
+	JSON_Value* root = json_value_init_object();
+	JSON_Object* obj = json_object(root);
+	json_object_set_string(obj, "world", argv[1]);
+	json_object_set_number(obj, "columns", loaded);
+	json_object_set_number(obj, "chunks", length);
+	json_object_set_number(obj, "chunks_skipped", skipped);
+	json_object_set_number(obj, "ingest_us_per_column",
+						   ingest_time * 1e6F / loaded);
+	json_object_set_number(obj, "storage_bytes_per_chunk",
+						   stored ? (double)storage / stored : 0.0);
+	bench_lookups(&gstate.world, obj);
+	bench_collisions(jobs, length, obj);
+
+	JSON_Value* runs = json_value_init_array();
+	json_array_append_value(json_array(runs), bench_run(jobs, length, 1));
+
+	if(threads > 1)
+		json_array_append_value(json_array(runs),
+								bench_run(jobs, length, threads));
+
+	// same chunks with the meshes used inside the fog
+	for(size_t k = 0; k < length; k++)
+		jobs[k].chunk->lod = true;
+
+	JSON_Value* lod = bench_run(jobs, length, 1);
+	json_object_set_boolean(json_object(lod), "lod", true);
+	json_array_append_value(json_array(runs), lod);
+
+	json_object_set_value(obj, "runs", runs);
+
+	char* str = json_serialize_to_string_pretty(root);
+	puts(str);
+
+	json_free_serialized_string(str);
+	json_value_free(root);
+	free(jobs);
+	world_destroy(&gstate.world);
+
+	return 0;
+}
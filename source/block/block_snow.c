@@ -43,7 +43,8 @@ getSideMask1(struct block_info* this, enum side side, struct block_info* it) {
 	switch(side) {
 		case SIDE_TOP: return face_occlusion_empty();
 		case SIDE_BOTTOM: return face_occlusion_full();
-		default: return face_occlusion_rect((this->block->metadata + 1) * 2);
+		default:
+			return face_occlusion_rect(((this->block->metadata & 7) + 1) * 2);
 	}
 }
 
@@ -24,6 +24,119 @@
 #include "blocks.h"
 
 struct block* blocks[256];
+bool blocks_full_opaque[256];
+uint8_t blocks_side_mask[256][16][SIDE_MAX];
+uint64_t blocks_mask_visible[BLOCKS_MASK_MAX];
+
+// index 0 is reserved for masks that need the getSideMask() callbacks
+static struct face_occlusion* blocks_masks[BLOCKS_MASK_MAX];
+static size_t blocks_masks_length;
+
+/* calls getSideMask() with varied surroundings, returns NULL if the result
+ * depends on anything but type, metadata and side */
+static struct face_occlusion* blocks_probe_side_mask(uint8_t type,
+													 uint8_t metadata,
+													 enum side side) {
+	assert(blocks[type]);
+
+	uint8_t others[3] = {type, BLOCK_STONE, BLOCK_LEAVES};
+	struct block_data surroundings[3][6];
+
+	for(int k = 0; k < 6; k++) {
+		surroundings[0][k] = (struct block_data) {.type = BLOCK_AIR};
+		surroundings[1][k] = (struct block_data) {.type = BLOCK_STONE};
+		surroundings[2][k] = (struct block_data) {.type = type};
+	}
+
+	struct face_occlusion* res = NULL;
+
+	for(int i = 0; i < 3; i++) {
+		for(int j = 0; j < 3; j++) {
+			struct block_data blk = (struct block_data) {
+				.type = type,
+				.metadata = metadata,
+			};
+
+			struct block_data other_blk
+				= (struct block_data) {.type = others[j]};
+
+			struct block_info this = (struct block_info) {
+				.block = &blk,
+				.neighbours = surroundings[i],
+			};
+
+			struct block_info other = (struct block_info) {
+				.block = &other_blk,
+			};
+
+			struct face_occlusion* mask
+				= blocks[type]->getSideMask(&this, side, &other);
+
+			if(res && mask != res)
+				return NULL;
+
+			res = mask;
+		}
+	}
+
+	return res;
+}
+
+static uint8_t blocks_mask_id(struct face_occlusion* mask) {
+	if(!mask)
+		return 0;
+
+	for(size_t k = 1; k < blocks_masks_length; k++) {
+		if(blocks_masks[k] == mask)
+			return k;
+	}
+
+	// out of IDs, falls back to the callbacks
+	if(blocks_masks_length >= BLOCKS_MASK_MAX)
+		return 0;
+
+	blocks_masks[blocks_masks_length] = mask;
+	return blocks_masks_length++;
+}
+
+static void blocks_init_masks(void) {
+	blocks_masks_length = 1;
+
+	for(int k = 0; k < 256; k++) {
+		for(int m = 0; m < 16; m++) {
+			for(int s = 0; s < SIDE_MAX; s++) {
+				blocks_side_mask[k][m][s] = blocks[k] ?
+					blocks_mask_id(blocks_probe_side_mask(k, m, s)) :
+					0;
+			}
+		}
+	}
+
+	for(size_t a = 0; a < BLOCKS_MASK_MAX; a++)
+		blocks_mask_visible[a] = 0;
+
+	for(size_t a = 1; a < blocks_masks_length; a++) {
+		for(size_t b = 1; b < blocks_masks_length; b++) {
+			if(face_occlusion_test(blocks_masks[a], blocks_masks[b]))
+				blocks_mask_visible[a] |= (uint64_t)1 << b;
+		}
+	}
+
+	uint8_t full = blocks_mask_id(face_occlusion_full());
+
+	for(int k = 0; k < 256; k++) {
+		struct block* b = blocks[k];
+		blocks_full_opaque[k] = b && full && !b->transparent
+			&& !b->can_see_through && !b->double_sided && !b->renderBlockAlways;
+
+		for(int m = 0; m < 16 && blocks_full_opaque[k]; m++) {
+			for(int s = 0; s < SIDE_MAX; s++) {
+				if(blocks_side_mask[k][m][s] != full)
+					blocks_full_opaque[k] = false;
+			}
+		}
+	}
+}
 
 void blocks_init() {
 	for(int k = 0; k < 256; k++)
@@ -140,6 +253,8 @@ void blocks_init() {
 			assert(blocks[k]->block_item.onItemPlace);
 		}
 	}
+
+	blocks_init_masks();
 }
 
 enum side blocks_side_opposite(enum side s) {
@@ -234,4 +349,4 @@ size_t block_drop_default(struct block_info* this, struct item_data* it,
 	}
 
 	return 1;
-}
\ No newline at end of file
+}
\ No newline at end of file
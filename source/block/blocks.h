@@ -155,6 +155,17 @@ extern struct block block_wooden_door;
 extern struct block block_iron_door;
 
 extern struct block* blocks[256];
+/* types that hide every face of a neighbouring type of this table and get
+ * hidden by them, for any metadata */
+extern bool blocks_full_opaque[256];
+
+#define BLOCKS_MASK_MAX 64
+
+/* IDs of side masks that only depend on type, metadata and side, 0 for those
+ * that need the getSideMask() callbacks */
+extern uint8_t blocks_side_mask[256][16][SIDE_MAX];
+// bit b of entry a is set if a face with mask a is visible against mask b
+extern uint64_t blocks_mask_visible[BLOCKS_MASK_MAX];
 
 #include "../graphics/render_block.h"
 #include "../graphics/render_item.h"
@@ -17,6 +17,8 @@
 	along with CavEX.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <assert.h>
+
 #include "face_occlusion.h"
 
 struct face_occlusion face_occlusion_s[] = {
@@ -90,6 +92,7 @@ struct face_occlusion* face_occlusion_empty() {
 }
 
 struct face_occlusion* face_occlusion_rect(int size) {
+	assert(size >= 0 && size <= 16);
 	return face_occlusion_s + size;
 }
 
@@ -0,0 +1,98 @@
+/*
+	Copyright (c) 2025 Lunna5
+
+	This file is part of CavEX.
+
+	CavEX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	CavEX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with CavEX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "block_volume.h"
+#include "world.h"
+
+void block_volume_init(struct block_volume* v, w_coord_t x1, w_coord_t y1,
+					   w_coord_t z1, w_coord_t x2, w_coord_t y2, w_coord_t z2) {
+	assert(v && x1 <= x2 && y1 <= y2 && z1 <= z2);
+
+	v->x = x1;
+	v->y = y1;
+	v->z = z1;
+	v->width = x2 - x1;
+	v->height = y2 - y1;
+	v->depth = z2 - z1;
+
+	size_t length = (size_t)v->width * v->height * v->depth;
+
+	v->chunk_x = WCOORD_CHUNK_OFFSET(x1);
+	v->chunk_y = WCOORD_CHUNK_OFFSET(y1);
+	v->chunk_z = WCOORD_CHUNK_OFFSET(z1);
+
+	if(length > 0) {
+		v->chunk_width = WCOORD_CHUNK_OFFSET(x2 - 1) - v->chunk_x + 1;
+		v->chunk_height = WCOORD_CHUNK_OFFSET(y2 - 1) - v->chunk_y + 1;
+		v->chunk_depth = WCOORD_CHUNK_OFFSET(z2 - 1) - v->chunk_z + 1;
+	} else {
+		v->chunk_width = v->chunk_height = v->chunk_depth = 0;
+	}
+
+	v->fetch = NULL;
+	size_t chunks
+		= (size_t)v->chunk_width * v->chunk_height * v->chunk_depth;
+
+	if(length <= BLOCK_VOLUME_LOCAL) {
+		v->blocks = v->local;
+		v->cached = v->local_cached;
+	} else {
+		v->blocks = malloc(length * sizeof(struct block_data));
+		v->cached = malloc(length * sizeof(bool));
+		assert(v->blocks && v->cached);
+	}
+
+	if(chunks <= BLOCK_VOLUME_LOCAL_CHUNKS) {
+		v->chunks = v->local_chunks;
+	} else {
+		v->chunks = malloc(chunks * sizeof(void*));
+		assert(v->chunks);
+	}
+
+	memset(v->cached, false, length * sizeof(bool));
+}
+
+void block_volume_destroy(struct block_volume* v) {
+	assert(v);
+
+	if(v->blocks != v->local) {
+		free(v->blocks);
+		free(v->cached);
+	}
+
+	if(v->chunks != v->local_chunks)
+		free(v->chunks);
+}
+
+void block_volume_fetch(struct block_volume* v, size_t index, w_coord_t x,
+						w_coord_t y, w_coord_t z) {
+	assert(v && v->fetch && block_volume_contains(v, x, y, z));
+
+	// relative to the first chunk, so all divisions are unsigned
+	size_t cx = (W2C_COORD(v->x) + (x - v->x)) / CHUNK_SIZE;
+	size_t cy = (W2C_COORD(v->y) + (y - v->y)) / CHUNK_SIZE;
+	size_t cz = (W2C_COORD(v->z) + (z - v->z)) / CHUNK_SIZE;
+	size_t chunk = cx + (cz + cy * v->chunk_depth) * v->chunk_width;
+
+	v->fetch(v->chunks[chunk], x, y, z, v->blocks + index);
+	v->cached[index] = true;
+}
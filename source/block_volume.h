@@ -0,0 +1,76 @@
+/*
+	Copyright (c) 2025 Lunna5
+
+	This file is part of CavEX.
+
+	CavEX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	CavEX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with CavEX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BLOCK_VOLUME_H
+#define BLOCK_VOLUME_H
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "block/blocks_data.h"
+
+// large enough for the movement of entities, bigger boxes go to the heap
+#define BLOCK_VOLUME_LOCAL 192
+#define BLOCK_VOLUME_LOCAL_CHUNKS 8
+
+/* view on the blocks inside [x1, x2) x [y1, y2) x [z1, z2), the chunks covering
+ * it are resolved once and each block is only decoded on its first access */
+struct block_volume {
+	w_coord_t x, y, z;
+	w_coord_t width, height, depth;
+	w_coord_t chunk_x, chunk_y, chunk_z;
+	w_coord_t chunk_width, chunk_height, chunk_depth;
+	void** chunks;
+	void (*fetch)(void* chunk, w_coord_t x, w_coord_t y, w_coord_t z,
+				  struct block_data* blk);
+	struct block_data* blocks;
+	bool* cached;
+	void* local_chunks[BLOCK_VOLUME_LOCAL_CHUNKS];
+	struct block_data local[BLOCK_VOLUME_LOCAL];
+	bool local_cached[BLOCK_VOLUME_LOCAL];
+};
+
+void block_volume_init(struct block_volume* v, w_coord_t x1, w_coord_t y1,
+					   w_coord_t z1, w_coord_t x2, w_coord_t y2, w_coord_t z2);
+void block_volume_destroy(struct block_volume* v);
+void block_volume_fetch(struct block_volume* v, size_t index, w_coord_t x,
+						w_coord_t y, w_coord_t z);
+
+static inline bool block_volume_contains(struct block_volume* v, w_coord_t x,
+										 w_coord_t y, w_coord_t z) {
+	return x >= v->x && y >= v->y && z >= v->z && x < v->x + v->width
+		&& y < v->y + v->height && z < v->z + v->depth;
+}
+
+static inline struct block_data*
+block_volume_get(struct block_volume* v, w_coord_t x, w_coord_t y,
+				 w_coord_t z) {
+	assert(v && v->fetch && block_volume_contains(v, x, y, z));
+
+	size_t index
+		= (x - v->x) + ((z - v->z) + (y - v->y) * v->depth) * v->width;
+
+	if(!v->cached[index])
+		block_volume_fetch(v, index, x, y, z);
+
+	return v->blocks + index;
+}
+
+#endif
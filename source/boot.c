@@ -33,6 +33,7 @@
 #include "log/log.h"
 #include "chunk_mesher.h"
 #include "daytime.h"
+#include "far_terrain.h"
 #include "game/game_state.h"
 #include "game/gui/screen.h"
 #include "graphics/gfx_util.h"
@@ -60,6 +61,7 @@ int boot(void) {
 	gstate.config.fov = 70.0F;
 	gstate.config.render_distance = 192.0F;
 	gstate.config.fog_distance = 5 * 16.0F;
+	gstate.config.horizon_distance = gstate.config.fog_distance;
 	gstate.world_loaded = false;
 	gstate.held_item_animation.punch.start = time_get();
 	gstate.held_item_animation.switch_item.start = time_get();
@@ -82,6 +84,10 @@ int boot(void) {
 
 	screen_set(&screen_select_world);
 
+	// enough chunks for a full view, streaming them in then skips malloc
+	bool preallocate
+		= config_read_int(&gstate.config_user, "memory.preallocate", 1);
+	chunk_pool_init(preallocate ? MAX_CHUNKS * COLUMN_HEIGHT : 0);
 	world_create(&gstate.world);
 
 	for(size_t k = 0; k < 256; k++)
@@ -90,6 +96,8 @@ int boot(void) {
 	clin_init();
 	svin_init();
 	chunk_mesher_init();
+	region_archive_init();
+	far_terrain_init();
 	particle_init();
 
 	dict_entity_init(gstate.entities);
@@ -159,7 +167,7 @@ int boot(void) {
 		}
 
 		world_update_lighting(&gstate.world);
-		world_build_chunks(&gstate.world, CHUNK_MESHER_QLENGTH);
+		world_build_chunks(&gstate.world, chunk_mesher_capacity());
 
 		if(gstate.current_screen->update)
 			gstate.current_screen->update(gstate.current_screen,
@@ -169,6 +177,10 @@ int boot(void) {
 
 		// must not modify displaylists while still rendering!
 		chunk_mesher_receive();
+
+		if(render_world)
+			far_terrain_update(&gstate.world, gstate.camera.x,
+							   gstate.camera.z);
 		world_render_completed(&gstate.world, render_world);
 
 		vec3 top_plane_color, bottom_plane_color, atmosphere_color;
@@ -199,6 +211,7 @@ int boot(void) {
 
 			gstate.stats.chunks_rendered
 				= world_render(&gstate.world, &gstate.camera, false);
+			far_terrain_render(&gstate.world, &gstate.camera);
 		} else {
 			gstate.stats.chunks_rendered = 0;
 		}
@@ -26,31 +26,111 @@
 #include "block/blocks.h"
 #include "chunk.h"
 #include "game/game_state.h"
+#include "palette.h"
 #include "platform/gfx.h"
 #include "stack.h"
 
-#define CHUNK_INDEX(x, y, z) ((x) + ((z) + (y) * CHUNK_SIZE) * CHUNK_SIZE)
 #define CHUNK_LIGHT_INDEX(x, y, z)                                             \
 	((x) + ((z) + (y) * (CHUNK_SIZE + 2)) * (CHUNK_SIZE + 2))
 
+static struct pool chunk_pool;
+static struct pool storage_pool;
+
+void chunk_pool_init(size_t reserve) {
+	pool_create(&chunk_pool, sizeof(struct chunk), reserve);
+	pool_create(&storage_pool, sizeof(struct chunk_storage), reserve);
+	palette_pool_init();
+}
+
+struct chunk* chunk_alloc(void) {
+	return pool_alloc(&chunk_pool);
+}
+
+void chunk_get_pool_stats(struct pool_stats* chunks,
+						  struct pool_stats* blocks) {
+	assert(chunks && blocks);
+	pool_get_stats(&chunk_pool, chunks);
+	palette_get_pool_stats(blocks);
+
+	struct pool_stats storage;
+	pool_get_stats(&storage_pool, &storage);
+	blocks->hits += storage.hits;
+	blocks->misses += storage.misses;
+	blocks->in_use += storage.in_use;
+	blocks->capacity += storage.capacity;
+}
+
+static struct chunk_storage* chunk_storage_create(void) {
+	struct chunk_storage* s = pool_alloc(&storage_pool);
+	palette_init(&s->blocks, BLOCK_AIR);
+	palette_init(&s->light, 0);
+	s->references = 1;
+	return s;
+}
+
+static void chunk_storage_ref(struct chunk_storage* s) {
+	assert(s);
+	s->references++;
+}
+
+static void chunk_storage_unref(struct chunk_storage* s) {
+	assert(s && s->references > 0);
+	s->references--;
+
+	if(!s->references) {
+		palette_destroy(&s->blocks);
+		palette_destroy(&s->light);
+		pool_free(&storage_pool, s);
+	}
+}
+
+// copies the storage of c before a change if a pin still reads it
+static void chunk_storage_own(struct chunk* c) {
+	assert(c);
+
+	if(c->storage->references == 1)
+		return;
+
+	struct chunk_storage* s = pool_alloc(&storage_pool);
+	palette_copy(&s->blocks, &c->storage->blocks);
+	palette_copy(&s->light, &c->storage->light);
+	s->references = 1;
+
+	chunk_storage_unref(c->storage);
+	c->storage = s;
+}
+
 void chunk_init(struct chunk* c, struct world* world, w_coord_t x, w_coord_t y,
 				w_coord_t z) {
 	assert(c && world);
 
-	c->blocks = malloc(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE * 5 / 2);
-	assert(c->blocks);
-
-	memset(c->blocks, BLOCK_AIR, CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE * 5 / 2);
+	c->storage = chunk_storage_create();
 
 	c->x = x;
 	c->y = y;
 	c->z = z;
 
+	c->non_air = 0;
+	c->opaque = 0;
+	for(int k = 0; k < 6; k++)
+		c->face_opaque[k] = 0;
+
 	for(int k = 0; k < 13; k++)
 		c->has_displist[k] = false;
+	c->has_mesh = false;
+	c->mesh_stats = (struct chunk_mesher_stats) {0};
+	c->mesh_generation = 0;
+	c->mesh_request = NULL;
 	c->rebuild_displist = false;
+	c->mesh_incomplete = false;
+	c->mesh_edited = false;
+	c->waiting_pass = 0;
+	c->lod = false;
 	c->world = world;
+	for(int k = 0; k < 6; k++)
+		c->neighbours[k] = NULL;
 	c->reference_count = 0;
+	c->tmp_data.visited = false;
 
 	ilist_chunks_init_field(c);
 	ilist_chunks2_init_field(c);
@@ -59,14 +139,13 @@ void chunk_init(struct chunk* c, struct world* world, w_coord_t x, w_coord_t y,
 static void chunk_destroy(struct chunk* c) {
 	assert(c);
 
-	free(c->blocks);
+	chunk_storage_unref(c->storage);
+	chunk_mesher_release(c);
 
-	for(int k = 0; k < 13; k++) {
-		if(c->has_displist[k])
-			displaylist_destroy(c->mesh + k);
-	}
+	if(c->has_mesh)
+		displaylist_batch_destroy(&c->mesh);
 
-	free(c);
+	pool_free(&chunk_pool, c);
 }
 
 void chunk_ref(struct chunk* c) {
@@ -82,26 +161,40 @@ void chunk_unref(struct chunk* c) {
 		chunk_destroy(c);
 }
 
-struct block_data chunk_get_block(struct chunk* c, c_coord_t x, c_coord_t y,
-								  c_coord_t z) {
-	assert(c && x < CHUNK_SIZE && y < CHUNK_SIZE && z < CHUNK_SIZE);
-
-	size_t idx = CHUNK_INDEX(x, y, z) / 2 * 5;
-	size_t off = CHUNK_INDEX(x, y, z) % 2;
+static struct block_data chunk_storage_get_block(struct chunk_storage* s,
+												 c_coord_t x, c_coord_t y,
+												 c_coord_t z) {
+	assert(s && x < CHUNK_SIZE && y < CHUNK_SIZE && z < CHUNK_SIZE);
 
 	/* storage layout:
-		type 0
-		type 1
-		light 0
-		light 1
-		meta 1/0
+		blocks: type | metadata << 8
+		light: torch_light << 4 | sky_light
 	*/
 
+	uint16_t blk = palette_get(&s->blocks, CHUNK_INDEX(x, y, z));
+	uint16_t light = palette_get(&s->light, CHUNK_INDEX(x, y, z));
+
 	return (struct block_data) {
-		.type = c->blocks[idx + off + 0],
-		.metadata = (c->blocks[idx + 4] >> (off * 4)) & 0xF,
-		.sky_light = c->blocks[idx + off + 2] & 0xF,
-		.torch_light = c->blocks[idx + off + 2] >> 4,
+		.type = blk & 0xFF,
+		.metadata = blk >> 8,
+		.sky_light = light & 0xF,
+		.torch_light = light >> 4,
+	};
+}
+
+struct block_data chunk_get_block(struct chunk* c, c_coord_t x, c_coord_t y,
+								  c_coord_t z) {
+	assert(c);
+	return chunk_storage_get_block(c->storage, x, y, z);
+}
+
+// stands in for blocks of chunks that are not loaded, y in world coordinates
+static struct block_data chunk_missing_block(w_coord_t y) {
+	return (struct block_data) {
+		.type = (y < WORLD_HEIGHT) ? 1 : 0,
+		.metadata = 0,
+		.sky_light = (y < WORLD_HEIGHT) ? 0 : 15,
+		.torch_light = 0,
 	};
 }
 
@@ -117,12 +210,104 @@ struct block_data chunk_lookup_block(struct chunk* c, w_coord_t x, w_coord_t y,
 
 	return other ?
 		chunk_get_block(other, W2C_COORD(x), W2C_COORD(y), W2C_COORD(z)) :
-		(struct block_data) {
-			.type = (y < WORLD_HEIGHT) ? 1 : 0,
-			.metadata = 0,
-			.sky_light = (y < WORLD_HEIGHT) ? 0 : 15,
-			.torch_light = 0,
+		chunk_missing_block(c->y + y);
+}
+
+static void chunk_storage_get_row(struct chunk_storage* s, c_coord_t y,
+								  c_coord_t z, struct block_data* out) {
+	assert(s && y < CHUNK_SIZE && z < CHUNK_SIZE && out);
+
+	uint16_t blk[CHUNK_SIZE], light[CHUNK_SIZE];
+	palette_get_range(&s->blocks, CHUNK_INDEX(0, y, z), CHUNK_SIZE, blk);
+	palette_get_range(&s->light, CHUNK_INDEX(0, y, z), CHUNK_SIZE, light);
+
+	for(c_coord_t x = 0; x < CHUNK_SIZE; x++) {
+		out[x] = (struct block_data) {
+			.type = blk[x] & 0xFF,
+			.metadata = blk[x] >> 8,
+			.sky_light = light[x] & 0xF,
+			.torch_light = light[x] >> 4,
 		};
+	}
+}
+
+void chunk_pin(struct chunk* c, struct chunk_pin* p) {
+	assert(c && p);
+
+	p->y = c->y;
+
+	for(int y = 0; y < 3; y++) {
+		for(int z = 0; z < 3; z++) {
+			for(int x = 0; x < 3; x++) {
+				struct chunk* other = (x == 1 && y == 1 && z == 1) ?
+					c :
+					world_find_chunk(c->world, c->x + (x - 1) * CHUNK_SIZE,
+									 c->y + (y - 1) * CHUNK_SIZE,
+									 c->z + (z - 1) * CHUNK_SIZE);
+
+				p->storage[y][z][x] = other ? other->storage : NULL;
+
+				if(other)
+					chunk_storage_ref(other->storage);
+			}
+		}
+	}
+}
+
+void chunk_unpin(struct chunk_pin* p) {
+	assert(p);
+
+	for(int y = 0; y < 3; y++) {
+		for(int z = 0; z < 3; z++) {
+			for(int x = 0; x < 3; x++) {
+				if(p->storage[y][z][x])
+					chunk_storage_unref(p->storage[y][z][x]);
+				p->storage[y][z][x] = NULL;
+			}
+		}
+	}
+}
+
+void chunk_pin_snapshot(struct chunk_pin* p, struct block_data* out) {
+	assert(p && out);
+
+	for(w_coord_t y = -1; y < CHUNK_SIZE + 1; y++) {
+		int ny = (y < 0) ? 0 : ((y < CHUNK_SIZE) ? 1 : 2);
+
+		for(w_coord_t z = -1; z < CHUNK_SIZE + 1; z++) {
+			int nz = (z < 0) ? 0 : ((z < CHUNK_SIZE) ? 1 : 2);
+			struct chunk_storage** row_storage = p->storage[ny][nz];
+			struct block_data* row = out
+				+ ((z + 1) + (y + 1) * (CHUNK_SIZE + 2)) * (CHUNK_SIZE + 2);
+
+			row[0] = row_storage[0] ?
+				chunk_storage_get_block(row_storage[0], CHUNK_SIZE - 1,
+										W2C_COORD(y), W2C_COORD(z)) :
+				chunk_missing_block(p->y + y);
+
+			if(row_storage[1]) {
+				chunk_storage_get_row(row_storage[1], W2C_COORD(y),
+									  W2C_COORD(z), row + 1);
+			} else {
+				for(c_coord_t x = 0; x < CHUNK_SIZE; x++)
+					row[x + 1] = chunk_missing_block(p->y + y);
+			}
+
+			row[CHUNK_SIZE + 1] = row_storage[2] ?
+				chunk_storage_get_block(row_storage[2], 0, W2C_COORD(y),
+										W2C_COORD(z)) :
+				chunk_missing_block(p->y + y);
+		}
+	}
+}
+
+void chunk_snapshot(struct chunk* c, struct block_data* out) {
+	assert(c && out);
+
+	struct chunk_pin p;
+	chunk_pin(c, &p);
+	chunk_pin_snapshot(&p, out);
+	chunk_unpin(&p);
 }
 
 static void chunk_trigger_neighbour_update(struct chunk* c, c_coord_t x,
@@ -130,22 +315,15 @@ static void chunk_trigger_neighbour_update(struct chunk* c, c_coord_t x,
 	// TODO: diagonal chunks, just sharing edge or single point
 
 	bool cond[6] = {
-		x == 0, x == CHUNK_SIZE - 1, y == 0, y == CHUNK_SIZE - 1,
-		z == 0, z == CHUNK_SIZE - 1,
-	};
-
-	int offset[6][3] = {
-		{-1, 0, 0},			{CHUNK_SIZE, 0, 0}, {0, -1, 0},
-		{0, CHUNK_SIZE, 0}, {0, 0, -1},			{0, 0, CHUNK_SIZE},
+		[SIDE_LEFT] = x == 0,	 [SIDE_RIGHT] = x == CHUNK_SIZE - 1,
+		[SIDE_BOTTOM] = y == 0,	 [SIDE_TOP] = y == CHUNK_SIZE - 1,
+		[SIDE_FRONT] = z == 0, [SIDE_BACK] = z == CHUNK_SIZE - 1,
 	};
 
 	for(int k = 0; k < 6; k++) {
-		if(cond[k]) {
-			struct chunk* other
-				= world_find_chunk(c->world, c->x + offset[k][0],
-								   c->y + offset[k][1], c->z + offset[k][2]);
-			if(other)
-				other->rebuild_displist = true;
+		if(cond[k] && c->neighbours[k]) {
+			c->neighbours[k]->mesh_edited = true;
+			chunk_mark_dirty(c->neighbours[k]);
 		}
 	}
 }
@@ -154,36 +332,147 @@ void chunk_set_light(struct chunk* c, c_coord_t x, c_coord_t y, c_coord_t z,
 					 uint8_t light) {
 	assert(c && x < CHUNK_SIZE && y < CHUNK_SIZE && z < CHUNK_SIZE);
 
-	size_t idx = CHUNK_INDEX(x, y, z) / 2 * 5;
-	size_t off = CHUNK_INDEX(x, y, z) % 2;
-
-	c->blocks[idx + off + 2] = light;
-	c->rebuild_displist = true;
+	chunk_storage_own(c);
+	palette_set(&c->storage->light, CHUNK_INDEX(x, y, z), light);
+	c->mesh_edited = true;
+	chunk_mark_dirty(c);
 
 	chunk_trigger_neighbour_update(c, x, y, z);
 }
 
+static void chunk_count_block(struct chunk* c, c_coord_t x, c_coord_t y,
+							  c_coord_t z, uint8_t type, int delta) {
+	assert(c);
+
+	if(type != BLOCK_AIR)
+		c->non_air += delta;
+
+	if(!blocks_full_opaque[type])
+		return;
+
+	c->opaque += delta;
+
+	if(x == 0)
+		c->face_opaque[SIDE_LEFT] += delta;
+	if(x == CHUNK_SIZE - 1)
+		c->face_opaque[SIDE_RIGHT] += delta;
+	if(y == 0)
+		c->face_opaque[SIDE_BOTTOM] += delta;
+	if(y == CHUNK_SIZE - 1)
+		c->face_opaque[SIDE_TOP] += delta;
+	if(z == 0)
+		c->face_opaque[SIDE_FRONT] += delta;
+	if(z == CHUNK_SIZE - 1)
+		c->face_opaque[SIDE_BACK] += delta;
+}
+
 void chunk_set_block(struct chunk* c, c_coord_t x, c_coord_t y, c_coord_t z,
 					 struct block_data blk) {
 	assert(c && x < CHUNK_SIZE && y < CHUNK_SIZE && z < CHUNK_SIZE);
 
-	size_t idx = CHUNK_INDEX(x, y, z) / 2 * 5;
-	size_t off = CHUNK_INDEX(x, y, z) % 2;
+	size_t idx = CHUNK_INDEX(x, y, z);
+
+	chunk_count_block(c, x, y, z, palette_get(&c->storage->blocks, idx) & 0xFF,
+					  -1);
+	chunk_count_block(c, x, y, z, blk.type, 1);
 
-	c->blocks[idx + off + 0] = blk.type;
-	c->blocks[idx + off + 2] = (blk.torch_light << 4) | blk.sky_light;
-	c->blocks[idx + 4] = (c->blocks[idx + 4] & ~(0x0F << (off * 4)))
-		| (blk.metadata << (off * 4));
-	c->rebuild_displist = true;
+	chunk_storage_own(c);
+	palette_set(&c->storage->blocks, idx, blk.type | (blk.metadata << 8));
+	palette_set(&c->storage->light, idx,
+				(blk.torch_light << 4) | blk.sky_light);
+	c->mesh_edited = true;
+	chunk_mark_dirty(c);
 
 	chunk_trigger_neighbour_update(c, x, y, z);
 }
 
+void chunk_load(struct chunk* c, const uint16_t* blocks,
+				const uint16_t* light) {
+	assert(c && blocks && light);
+
+	// all blocks are replaced, a pinned storage needs no copy
+	if(c->storage->references > 1) {
+		chunk_storage_unref(c->storage);
+		c->storage = chunk_storage_create();
+	}
+
+	palette_fill(&c->storage->blocks, blocks);
+	palette_fill(&c->storage->light, light);
+
+	c->non_air = 0;
+	c->opaque = 0;
+	for(int k = 0; k < 6; k++)
+		c->face_opaque[k] = 0;
+
+	for(c_coord_t y = 0; y < CHUNK_SIZE; y++) {
+		for(c_coord_t z = 0; z < CHUNK_SIZE; z++) {
+			for(c_coord_t x = 0; x < CHUNK_SIZE; x++)
+				chunk_count_block(c, x, y, z,
+								  blocks[CHUNK_INDEX(x, y, z)] & 0xFF, 1);
+		}
+	}
+
+	c->mesh_edited = false;
+	chunk_mark_dirty(c);
+}
+
+size_t chunk_storage_bytes(struct chunk* c) {
+	assert(c);
+	return palette_bytes(&c->storage->blocks)
+		+ palette_bytes(&c->storage->light);
+}
+
+// whether all blocks and the facing sides of all neighbours are opaque
+bool chunk_enclosed(struct chunk* c) {
+	assert(c);
+
+	if(c->opaque < CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE)
+		return false;
+
+	for(int s = 0; s < SIDE_MAX; s++) {
+		struct chunk* other = world_find_chunk_neighbour(c->world, c, s);
+
+		/* missing horizontal neighbours and the one below the world are stone
+		 * in chunk_snapshot(), but there is air above the world */
+		if(!other && (s == SIDE_TOP || (s == SIDE_BOTTOM && c->y > 0)))
+			return false;
+
+		if(other
+		   && other->face_opaque[blocks_side_opposite(s)]
+			   < CHUNK_SIZE * CHUNK_SIZE)
+			return false;
+	}
+
+	return true;
+}
+
+void chunk_mark_dirty(struct chunk* c) {
+	assert(c);
+
+	if(!c->rebuild_displist) {
+		c->rebuild_displist = true;
+		c->dirty_since = time_get();
+	}
+}
+
 bool chunk_check_built(struct chunk* c) {
 	assert(c);
 
-	if(c->rebuild_displist && chunk_mesher_send(c)) {
+	if(!c->rebuild_displist)
+		return false;
+
+	// chunks found visible by the last world_bfs() are meshed first
+	struct chunk_mesher_priority priority = {
+		.visible = c->tmp_data.visited,
+		.distance = glm_vec3_distance2(
+			(vec3) {c->x + CHUNK_SIZE / 2, c->y + CHUNK_SIZE / 2,
+					c->z + CHUNK_SIZE / 2},
+			(vec3) {gstate.camera.x, gstate.camera.y, gstate.camera.z}),
+	};
+
+	if(chunk_mesher_send(c, priority)) {
 		c->rebuild_displist = false;
+		c->mesh_edited = false;
 		return true;
 	}
 
@@ -212,43 +501,42 @@ static void check_matrix_set(struct chunk* c, bool* needs_matrix) {
 void chunk_render(struct chunk* c, bool pass, float x, float y, float z) {
 	assert(c);
 
+	if(!c->has_mesh)
+		return;
+
 	bool needs_matrix = true;
 	int offset = pass ? 6 : 0;
 
-	if(y < c->y + CHUNK_SIZE && c->has_displist[SIDE_BOTTOM + offset]) {
-		check_matrix_set(c, &needs_matrix);
-		displaylist_render(c->mesh + SIDE_BOTTOM + offset);
-	}
+	uint8_t lists[6];
+	size_t count = 0;
 
-	if(y > c->y && c->has_displist[SIDE_TOP + offset]) {
-		check_matrix_set(c, &needs_matrix);
-		displaylist_render(c->mesh + SIDE_TOP + offset);
-	}
+	if(y < c->y + CHUNK_SIZE && c->has_displist[SIDE_BOTTOM + offset])
+		lists[count++] = SIDE_BOTTOM + offset;
 
-	if(x < c->x + CHUNK_SIZE && c->has_displist[SIDE_LEFT + offset]) {
-		check_matrix_set(c, &needs_matrix);
-		displaylist_render(c->mesh + SIDE_LEFT + offset);
-	}
+	if(y > c->y && c->has_displist[SIDE_TOP + offset])
+		lists[count++] = SIDE_TOP + offset;
 
-	if(x > c->x && c->has_displist[SIDE_RIGHT + offset]) {
-		check_matrix_set(c, &needs_matrix);
-		displaylist_render(c->mesh + SIDE_RIGHT + offset);
-	}
+	if(x < c->x + CHUNK_SIZE && c->has_displist[SIDE_LEFT + offset])
+		lists[count++] = SIDE_LEFT + offset;
 
-	if(z < c->z + CHUNK_SIZE && c->has_displist[SIDE_FRONT + offset]) {
-		check_matrix_set(c, &needs_matrix);
-		displaylist_render(c->mesh + SIDE_FRONT + offset);
-	}
+	if(x > c->x && c->has_displist[SIDE_RIGHT + offset])
+		lists[count++] = SIDE_RIGHT + offset;
+
+	if(z < c->z + CHUNK_SIZE && c->has_displist[SIDE_FRONT + offset])
+		lists[count++] = SIDE_FRONT + offset;
+
+	if(z > c->z && c->has_displist[SIDE_BACK + offset])
+		lists[count++] = SIDE_BACK + offset;
 
-	if(z > c->z && c->has_displist[SIDE_BACK + offset]) {
+	if(count > 0) {
 		check_matrix_set(c, &needs_matrix);
-		displaylist_render(c->mesh + SIDE_BACK + offset);
+		displaylist_batch_render(&c->mesh, lists, count);
 	}
 
 	if(!pass && c->has_displist[12]) {
 		check_matrix_set(c, &needs_matrix);
 		gfx_cull_func(MODE_NONE);
-		displaylist_render(c->mesh + 12);
+		displaylist_batch_render(&c->mesh, (uint8_t[]) {12}, 1);
 		gfx_cull_func(MODE_BACK);
 	}
 }
@@ -29,6 +29,7 @@
 
 #include "block/blocks.h"
 #include "chunk_mesher.h"
+#include "palette.h"
 #include "platform/displaylist.h"
 #include "world.h"
 
@@ -41,20 +42,62 @@
 	((((int64_t)(z)&0x3FFFFFFF) << 34) | (((int64_t)(x)&0x3FFFFFFF) << 4)      \
 	 | ((int64_t)(y)&0xF))
 #define W2C_COORD(x) ((x)&CHUNK_SIZE_BITS)
+#define CHUNK_INDEX(x, y, z) ((x) + ((z) + (y) * CHUNK_SIZE) * CHUNK_SIZE)
 
 typedef uint32_t c_coord_t;
 
+/* block storage shared between a chunk and the mesher requests reading it,
+ * copied by the next change while still shared */
+struct chunk_storage {
+	// type | metadata << 8
+	struct palette blocks;
+	// torch_light << 4 | sky_light
+	struct palette light;
+	// only changed by the main thread
+	uint32_t references;
+};
+
+// storage of a chunk and its neighbours, [y][z][x] with NULL for missing ones
+struct chunk_pin {
+	struct chunk_storage* storage[3][3][3];
+	// of the center chunk, for blocks of missing ones
+	w_coord_t y;
+};
+
 struct chunk {
 	mat4 model_view;
 	w_coord_t x, y, z;
-	uint8_t* blocks;
-	struct displaylist mesh[13];
+	struct chunk_storage* storage;
+	// block counts maintained by chunk_set_block()
+	uint16_t non_air;
+	uint16_t opaque;
+	// opaque blocks on each boundary face, indexed by enum side
+	uint16_t face_opaque[6];
+	struct displaylist_batch mesh;
+	bool has_mesh;
 	bool has_displist[13];
+	struct chunk_mesher_stats mesh_stats;
+	// bumped for every snapshot sent to the mesher
+	uint32_t mesh_generation;
+	// last request sent, cleared once its result is received
+	struct chunk_mesher_rpc* mesh_request;
 	bool rebuild_displist;
+	// when rebuild_displist was last set, for deferred meshing
+	ptime_t dirty_since;
+	// meshed while a horizontal neighbour was still missing
+	bool mesh_incomplete;
+	// blocks or light edited since the last mesh was sent, not worth caching
+	bool mesh_edited;
+	// world mesh_pass that last counted this chunk as waiting
+	uint32_t waiting_pass;
 	struct world* world;
+	// loaded chunks sharing a face, indexed by enum side, kept by world.c
+	struct chunk* neighbours[6];
 	uint8_t reachable[6];
 	size_t reference_count;
 	bool has_fog;
+	// meshed with reduced detail, switched by world_pre_render()
+	bool lod;
 	struct chunk_step {
 		bool visited;
 		enum side from;
@@ -68,6 +111,10 @@ struct chunk {
 ILIST_DEF(ilist_chunks, struct chunk, M_POD_OPLIST)
 ILIST_DEF(ilist_chunks2, struct chunk, M_POD_OPLIST)
 
+// reserve is the number of chunks allocated up front
+void chunk_pool_init(size_t reserve);
+struct chunk* chunk_alloc(void);
+void chunk_get_pool_stats(struct pool_stats* chunks, struct pool_stats* blocks);
 void chunk_init(struct chunk* c, struct world* world, w_coord_t x, w_coord_t y,
 				w_coord_t z);
 void chunk_ref(struct chunk* c);
@@ -76,8 +123,20 @@ struct block_data chunk_get_block(struct chunk* c, c_coord_t x, c_coord_t y,
 								  c_coord_t z);
 struct block_data chunk_lookup_block(struct chunk* c, w_coord_t x, w_coord_t y,
 									 w_coord_t z);
+// 18^3 blocks in x, z, y order including a one block border of neighbours
+void chunk_snapshot(struct chunk* c, struct block_data* out);
+// keeps the current blocks of c and its neighbours readable by other threads
+void chunk_pin(struct chunk* c, struct chunk_pin* p);
+void chunk_unpin(struct chunk_pin* p);
+// same as chunk_snapshot() at the time of chunk_pin(), on any thread
+void chunk_pin_snapshot(struct chunk_pin* p, struct block_data* out);
 void chunk_set_block(struct chunk* c, c_coord_t x, c_coord_t y, c_coord_t z,
 					 struct block_data blk);
+// replaces all blocks, in the storage layout of struct chunk
+void chunk_load(struct chunk* c, const uint16_t* blocks, const uint16_t* light);
+bool chunk_enclosed(struct chunk* c);
+size_t chunk_storage_bytes(struct chunk* c);
+void chunk_mark_dirty(struct chunk* c);
 bool chunk_check_built(struct chunk* c);
 void chunk_set_light(struct chunk* c, c_coord_t x, c_coord_t y, c_coord_t z,
 					 uint8_t light);
@@ -19,242 +19,523 @@
 
 #include <assert.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
 
 #include "chunk_mesher.h"
+#include "game/game_state.h"
+#include "graphics/render_block.h"
+#include "log/log.h"
+#include "mesh_cache.h"
 #include "platform/displaylist.h"
 #include "platform/thread.h"
-#include "stack.h"
+#include "pool.h"
+#include "vertex_light.h"
 #include "world.h"
 
 #define BLK_INDEX(x, y, z)                                                     \
 	((x) + ((z) + (y) * (CHUNK_SIZE + 2)) * (CHUNK_SIZE + 2))
-#define BLK_INDEX2(x, y, z) ((x) + ((z) + (y) * CHUNK_SIZE) * CHUNK_SIZE)
 #define BLK_DATA(b, x, y, z) ((b)[BLK_INDEX((x) + 1, (y) + 1, (z) + 1)])
+#define LIGHT_DATA(l, plane, x, y, z)                                          \
+	((l)[(plane)*VERTEX_LIGHT_VOLUME + BLK_INDEX(x, y, z)])
 
-#ifndef MAX
-#define MAX(a, b) ((a) > (b) ? (a) : (b))
-#endif
+#define GREEDY_INDEX(s, slice, u, v)                                           \
+	((u) + ((v) + ((slice) + (s)*CHUNK_SIZE) * CHUNK_SIZE) * CHUNK_SIZE)
+#define GREEDY_KEY(tex, luminance, light)                                      \
+	((1 << 24) | ((tex) << 16) | ((luminance) << 8) | (light))
 
 struct chunk_mesher_rpc {
 	struct chunk* chunk;
+	// chunk->mesh_generation at the time of the last snapshot
+	uint32_t generation;
+	// still in request_heap, protected by request_heap_lock
+	bool queued;
 	// ingoing
 	struct {
+		// released by the main thread once the result is received
+		struct chunk_pin pin;
+		// snapshot of pin, only set while a worker builds the mesh
 		struct block_data* blocks;
+		// no see-through blocks, nothing can be reached
+		bool opaque;
+		// reduced detail for chunks far inside the fog
+		bool lod;
+		// streamed in rather than edited, the mesh goes to the disk cache
+		bool cache;
+		struct chunk_mesher_priority priority;
 	} request;
 	// outgoing
-	struct {
-		struct displaylist mesh[13];
-		bool has_displist[13];
-		uint8_t reachable[6];
-	} result;
+	struct chunk_mesher_result result;
 };
 
-static struct chunk_mesher_rpc rpc_msg[CHUNK_MESHER_QLENGTH];
+static struct chunk_mesher_rpc* rpc_msg;
+static size_t rpc_msg_length;
+static size_t mesher_workers;
+
+/* requests are kept in a binary heap ordered by priority, mesher_requests only
+ * carries one wakeup token per queued request */
+static struct chunk_mesher_rpc** request_heap;
+static size_t request_heap_size;
+static struct thread_mutex request_heap_lock;
+// empty if the disk cache is off, protected by request_heap_lock
+static char mesher_cache_dir[256];
+static bool mesher_cache_enabled;
+
+static struct pool snapshot_pool;
+
 static struct thread_channel mesher_requests;
 static struct thread_channel mesher_results;
 static struct thread_channel mesher_empty_msg;
 
-static int chunk_test_side(enum side* on_sides, c_coord_t x, c_coord_t y,
-						   c_coord_t z) {
-	assert(on_sides);
+// only accessed by the main thread
+static struct chunk_mesher_stats mesher_stats;
 
-	int count = 0;
+// slice, width and height axis of a plane, as in render_block_full_merged
+static const uint8_t greedy_axes[SIDE_MAX][3] = {
+	[SIDE_TOP] = {1, 0, 2},	  [SIDE_BOTTOM] = {1, 0, 2},
+	[SIDE_LEFT] = {0, 2, 1},  [SIDE_RIGHT] = {0, 2, 1},
+	[SIDE_FRONT] = {2, 0, 1}, [SIDE_BACK] = {2, 0, 1},
+};
 
-	if(x == 0)
-		on_sides[count++] = SIDE_LEFT;
+// first of the four entries per side in vertex_light
+static const uint8_t side_light_offset[SIDE_MAX] = {
+	[SIDE_TOP] = 4,	  [SIDE_BOTTOM] = 0, [SIDE_LEFT] = 8,
+	[SIDE_RIGHT] = 12, [SIDE_FRONT] = 16, [SIDE_BACK] = 20,
+};
 
-	if(x == CHUNK_SIZE - 1)
-		on_sides[count++] = SIDE_RIGHT;
+static bool chunk_mesher_before(struct chunk_mesher_rpc* a,
+								struct chunk_mesher_rpc* b) {
+	assert(a && b);
 
-	if(y == 0)
-		on_sides[count++] = SIDE_BOTTOM;
+	if(a->request.priority.visible != b->request.priority.visible)
+		return a->request.priority.visible;
 
-	if(y == CHUNK_SIZE - 1)
-		on_sides[count++] = SIDE_TOP;
+	return a->request.priority.distance < b->request.priority.distance;
+}
+
+static void request_heap_push(struct chunk_mesher_rpc* req) {
+	assert(req && request_heap_size < rpc_msg_length);
 
-	if(z == 0)
-		on_sides[count++] = SIDE_FRONT;
+	size_t k = request_heap_size++;
 
-	if(z == CHUNK_SIZE - 1)
-		on_sides[count++] = SIDE_BACK;
+	while(k > 0 && chunk_mesher_before(req, request_heap[(k - 1) / 2])) {
+		request_heap[k] = request_heap[(k - 1) / 2];
+		k = (k - 1) / 2;
+	}
 
-	return count;
+	request_heap[k] = req;
 }
 
-static void chunk_test(struct block_data* bd, struct stack* queue,
-					   bool* visited, uint8_t* reachable, c_coord_t x,
-					   c_coord_t y, c_coord_t z) {
-	assert(bd && queue && visited && reachable);
-
-	if(visited[BLK_INDEX2(x, y, z)]
-	   || (blocks[BLK_DATA(bd, x, y, z).type]
-		   && !blocks[BLK_DATA(bd, x, y, z).type]->can_see_through))
-		return;
-
-	stack_clear(queue);
-	stack_push(queue, (uint8_t[]) {x, y, z});
-	visited[BLK_INDEX2(x, y, z)] = true;
-
-	uint8_t reached_sides = 0;
-
-	while(!stack_empty(queue)) {
-		uint8_t block[3];
-		stack_pop(queue, block);
-
-		enum side on_sides[3];
-		size_t on_sides_len
-			= chunk_test_side(on_sides, block[0], block[1], block[2]);
-		assert(on_sides_len <= 3);
-
-		for(size_t k = 0; k < on_sides_len; k++)
-			reached_sides |= (1 << on_sides[k]);
-
-		for(int s = 0; s < 6; s++) {
-			int nx, ny, nz;
-			blocks_side_offset(s, &nx, &ny, &nz);
-			nx += block[0];
-			ny += block[1];
-			nz += block[2];
-
-			if(nx >= 0 && ny >= 0 && nz >= 0 && nx < CHUNK_SIZE
-			   && ny < CHUNK_SIZE && nz < CHUNK_SIZE
-			   && !visited[BLK_INDEX2(nx, ny, nz)]
-			   && (!blocks[BLK_DATA(bd, nx, ny, nz).type]
-				   || blocks[BLK_DATA(bd, nx, ny, nz).type]->can_see_through)) {
-				stack_push(queue, (uint8_t[]) {nx, ny, nz});
-				visited[BLK_INDEX2(nx, ny, nz)] = true;
+static struct chunk_mesher_rpc* request_heap_pop(void) {
+	assert(request_heap_size > 0);
+
+	struct chunk_mesher_rpc* top = request_heap[0];
+	struct chunk_mesher_rpc* last = request_heap[--request_heap_size];
+	size_t k = 0;
+
+	while(k * 2 + 1 < request_heap_size) {
+		size_t child = k * 2 + 1;
+
+		if(child + 1 < request_heap_size
+		   && chunk_mesher_before(request_heap[child + 1], request_heap[child]))
+			child++;
+
+		if(!chunk_mesher_before(request_heap[child], last))
+			break;
+
+		request_heap[k] = request_heap[child];
+		k = child;
+	}
+
+	request_heap[k] = last;
+	return top;
+}
+
+// one bit per x coordinate, rows indexed by [y][z]
+typedef uint16_t chunk_rows_t[CHUNK_SIZE][CHUNK_SIZE];
+
+#define ROW_FULL 0xFFFF
+
+// grows the seed bits to the full runs of open they touch
+static uint16_t chunk_test_row_fill(uint16_t seed, uint16_t open) {
+	seed &= open;
+
+	while(1) {
+		uint16_t grown = (seed | (seed << 1) | (seed >> 1)) & open;
+
+		if(grown == seed)
+			return seed;
+
+		seed = grown;
+	}
+}
+
+static uint8_t chunk_test_flood(chunk_rows_t open, chunk_rows_t comp,
+								int y, int z, uint16_t seed) {
+	assert(open && comp && seed);
+
+	memset(comp, 0, sizeof(chunk_rows_t));
+	comp[y][z] = chunk_test_row_fill(seed, open[y][z]);
+
+	int y_min = y, y_max = y, z_min = z, z_max = z;
+	bool changed = true;
+
+	// alternate sweep direction, most caves converge in a few passes
+	for(int pass = 0; changed; pass++) {
+		changed = false;
+
+		int y0 = y_min > 0 ? y_min - 1 : 0;
+		int y1 = y_max < CHUNK_SIZE - 1 ? y_max + 1 : CHUNK_SIZE - 1;
+		int z0 = z_min > 0 ? z_min - 1 : 0;
+		int z1 = z_max < CHUNK_SIZE - 1 ? z_max + 1 : CHUNK_SIZE - 1;
+
+		for(int k = 0; k <= (y1 - y0); k++) {
+			int ry = (pass & 1) ? y1 - k : y0 + k;
+
+			for(int j = 0; j <= (z1 - z0); j++) {
+				int rz = (pass & 1) ? z1 - j : z0 + j;
+				uint16_t row = comp[ry][rz];
+				uint16_t next = row;
+
+				if(ry > 0)
+					next |= comp[ry - 1][rz];
+				if(ry < CHUNK_SIZE - 1)
+					next |= comp[ry + 1][rz];
+				if(rz > 0)
+					next |= comp[ry][rz - 1];
+				if(rz < CHUNK_SIZE - 1)
+					next |= comp[ry][rz + 1];
+
+				next &= open[ry][rz];
+
+				if(next == row)
+					continue;
+
+				comp[ry][rz] = chunk_test_row_fill(next, open[ry][rz]);
+				changed = true;
+
+				if(ry < y_min)
+					y_min = ry;
+				if(ry > y_max)
+					y_max = ry;
+				if(rz < z_min)
+					z_min = rz;
+				if(rz > z_max)
+					z_max = rz;
 			}
 		}
 	}
 
-	for(int s = 0; s < 6; s++) {
-		if(reached_sides & (1 << s))
-			reachable[s] |= reached_sides;
+	uint8_t sides = 0;
+	uint16_t any = 0;
+
+	for(int ry = y_min; ry <= y_max; ry++) {
+		for(int rz = z_min; rz <= z_max; rz++) {
+			uint16_t row = comp[ry][rz];
+			any |= row;
+
+			if(row && ry == 0)
+				sides |= 1 << SIDE_BOTTOM;
+			if(row && ry == CHUNK_SIZE - 1)
+				sides |= 1 << SIDE_TOP;
+			if(row && rz == 0)
+				sides |= 1 << SIDE_FRONT;
+			if(row && rz == CHUNK_SIZE - 1)
+				sides |= 1 << SIDE_BACK;
+		}
 	}
+
+	if(any & 1)
+		sides |= 1 << SIDE_LEFT;
+
+	if(any & (1 << (CHUNK_SIZE - 1)))
+		sides |= 1 << SIDE_RIGHT;
+
+	return sides;
 }
 
-static void chunk_test_init(struct block_data* bd, uint8_t* reachable) {
+void chunk_mesher_reachable(struct block_data* bd, uint8_t* reachable) {
 	assert(bd && reachable);
 
 	memset(reachable, 0, 6 * sizeof(uint8_t));
 
-	bool* visited = malloc(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE);
-	assert(visited);
-
-	memset(visited, false, CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE);
+	bool see_through[256];
+	for(int k = 0; k < 256; k++)
+		see_through[k] = !blocks[k] || blocks[k]->can_see_through;
 
-	struct stack queue;
-	stack_create(&queue, CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE / 4,
-				 sizeof(uint8_t[3]));
+	chunk_rows_t open, visited, comp;
 
 	for(int y = 0; y < CHUNK_SIZE; y++) {
-		for(int x = 0; x < CHUNK_SIZE; x++) {
-			chunk_test(bd, &queue, visited, reachable, x, y, 0);
-			chunk_test(bd, &queue, visited, reachable, x, 0, y);
-			chunk_test(bd, &queue, visited, reachable, 0, x, y);
-			chunk_test(bd, &queue, visited, reachable, x, y, CHUNK_SIZE - 1);
-			chunk_test(bd, &queue, visited, reachable, x, CHUNK_SIZE - 1, y);
-			chunk_test(bd, &queue, visited, reachable, CHUNK_SIZE - 1, x, y);
+		for(int z = 0; z < CHUNK_SIZE; z++) {
+			uint16_t row = 0;
+
+			for(int x = 0; x < CHUNK_SIZE; x++)
+				row |= see_through[BLK_DATA(bd, x, y, z).type] << x;
+
+			open[y][z] = row;
+			visited[y][z] = 0;
 		}
 	}
 
-	stack_destroy(&queue);
-	free(visited);
+	// flood once per component touching the chunk border
+	for(int y = 0; y < CHUNK_SIZE; y++) {
+		for(int z = 0; z < CHUNK_SIZE; z++) {
+			uint16_t border
+				= (y == 0 || y == CHUNK_SIZE - 1 || z == 0
+				   || z == CHUNK_SIZE - 1) ?
+				ROW_FULL :
+				(1 | (1 << (CHUNK_SIZE - 1)));
+			uint16_t seeds = open[y][z] & ~visited[y][z] & border;
+
+			while(seeds) {
+				uint8_t sides
+					= chunk_test_flood(open, comp, y, z, seeds & -seeds);
+
+				for(int s = 0; s < 6; s++) {
+					if(sides & (1 << s))
+						reachable[s] |= sides;
+				}
+
+				for(int ry = 0; ry < CHUNK_SIZE; ry++) {
+					for(int rz = 0; rz < CHUNK_SIZE; rz++)
+						visited[ry][rz] |= comp[ry][rz];
+				}
+
+				seeds &= ~visited[y][z];
+			}
+		}
+	}
 }
 
 static void chunk_mesher_vertex_light(struct block_data* bd,
 									  uint8_t* light_data) {
 	assert(bd && light_data);
 
-	const int shade_table[5] = {0, 5, 3, 1, 0};
+	uint8_t light_passes[256];
+	for(int k = 0; k < 256; k++)
+		light_passes[k] = !blocks[k]
+			|| (blocks[k]->can_see_through && !blocks[k]->ignore_lighting);
 
-	for(c_coord_t y = 0; y < CHUNK_SIZE + 2; y++) {
-		for(c_coord_t z = 0; z < CHUNK_SIZE + 2; z++) {
-			for(c_coord_t x = 0; x < CHUNK_SIZE + 2; x++) {
-				// TODO: clean up horrible code
+	size_t plane = VERTEX_LIGHT_VOLUME + VERTEX_LIGHT_PADDING;
+	uint8_t* passes = malloc(plane * 3);
+	assert(passes);
 
-				if(x != CHUNK_SIZE + 1 && z != CHUNK_SIZE + 1) {
-					struct block_data b1[4] = {
-						BLK_DATA(bd, x + 0, y - 1, z + 0),
-						BLK_DATA(bd, x - 1, y - 1, z + 0),
-						BLK_DATA(bd, x + 0, y - 1, z - 1),
-						BLK_DATA(bd, x - 1, y - 1, z - 1),
-					};
+	uint8_t* sky = passes + plane;
+	uint8_t* torch = passes + plane * 2;
 
-					int sum_sky = 0, sum_torch = 0, count = 0;
-					for(int k = 0; k < 4; k++) {
-						if(!blocks[b1[k].type]
-						   || (blocks[b1[k].type]->can_see_through
-							   && !blocks[b1[k].type]->ignore_lighting)) {
-							sum_sky += b1[k].sky_light;
-							sum_torch += b1[k].torch_light;
-							count++;
-						}
-					}
+	for(size_t k = 0; k < VERTEX_LIGHT_VOLUME; k++) {
+		uint8_t pass = light_passes[bd[k].type];
+		passes[k] = pass;
+		sky[k] = pass ? bd[k].sky_light : 0;
+		torch[k] = pass ? bd[k].torch_light : 0;
+	}
 
-					sum_torch = count > 0 ? (sum_torch + count - 1) / count : 0;
-					sum_sky = count > 0 ? (sum_sky + count - 1) / count : 0;
-					sum_torch = MAX(sum_torch - shade_table[count], 0);
-					sum_sky = MAX(sum_sky - shade_table[count], 0);
+	memset(passes + VERTEX_LIGHT_VOLUME, 0, VERTEX_LIGHT_PADDING);
+	memset(sky + VERTEX_LIGHT_VOLUME, 0, VERTEX_LIGHT_PADDING);
+	memset(torch + VERTEX_LIGHT_VOLUME, 0, VERTEX_LIGHT_PADDING);
 
-					light_data[BLK_INDEX(x, y, z) * 3 + 0]
-						= (sum_torch << 4) | sum_sky;
-				}
+	vertex_light_compute(passes, sky, torch, light_data);
+	free(passes);
+}
 
-				if(y != CHUNK_SIZE + 1 && z != CHUNK_SIZE + 1) {
-					struct block_data b2[4] = {
-						BLK_DATA(bd, x - 1, y + 0, z + 0),
-						BLK_DATA(bd, x - 1, y - 1, z + 0),
-						BLK_DATA(bd, x - 1, y + 0, z - 1),
-						BLK_DATA(bd, x - 1, y - 1, z - 1),
-					};
+static bool chunk_mesher_mergeable(struct block* b) {
+#ifdef DISPLAYLIST_TEXCOORD_REPEAT
+	return b->renderBlock == render_block_full && !b->transparent
+		&& !b->double_sided && !b->renderBlockAlways;
+#else
+	return false;
+#endif
+}
 
-					int sum_sky = 0, sum_torch = 0, count = 0;
-					for(int k = 0; k < 4; k++) {
-						if(!blocks[b2[k].type]
-						   || (blocks[b2[k].type]->can_see_through
-							   && !blocks[b2[k].type]->ignore_lighting)) {
-							sum_sky += b2[k].sky_light;
-							sum_torch += b2[k].torch_light;
-							count++;
-						}
-					}
+#ifdef DISPLAYLIST_TEXCOORD_REPEAT
+static bool greedy_row_equal(uint32_t* row, uint32_t key, c_coord_t length) {
+	for(c_coord_t k = 0; k < length; k++) {
+		if(row[k] != key)
+			return false;
+	}
 
-					sum_torch = count > 0 ? (sum_torch + count - 1) / count : 0;
-					sum_sky = count > 0 ? (sum_sky + count - 1) / count : 0;
-					sum_torch = MAX(sum_torch - shade_table[count], 0);
-					sum_sky = MAX(sum_sky - shade_table[count], 0);
+	return true;
+}
+
+static void chunk_mesher_greedy(uint32_t* faces, struct displaylist* d,
+								bool count_only, size_t* vertices,
+								struct chunk_mesher_stats* stats) {
+	assert(faces && d && vertices && stats);
+
+	for(int s = 0; s < SIDE_MAX; s++) {
+		for(c_coord_t slice = 0; slice < CHUNK_SIZE; slice++) {
+			uint32_t* plane = faces + GREEDY_INDEX(s, slice, 0, 0);
+
+			for(c_coord_t v = 0; v < CHUNK_SIZE; v++) {
+				for(c_coord_t u = 0; u < CHUNK_SIZE; u++) {
+					uint32_t key = plane[u + v * CHUNK_SIZE];
+
+					if(!key)
+						continue;
+
+					c_coord_t width = 1;
+					while(u + width < CHUNK_SIZE
+						  && plane[u + width + v * CHUNK_SIZE] == key)
+						width++;
+
+					c_coord_t height = 1;
+					while(v + height < CHUNK_SIZE
+						  && greedy_row_equal(
+							  plane + u + (v + height) * CHUNK_SIZE, key,
+							  width))
+						height++;
+
+					for(c_coord_t j = 0; j < height; j++)
+						memset(plane + u + (v + j) * CHUNK_SIZE, 0,
+							   width * sizeof(uint32_t));
+
+					c_coord_t pos[3];
+					pos[greedy_axes[s][0]] = slice;
+					pos[greedy_axes[s][1]] = u;
+					pos[greedy_axes[s][2]] = v;
+
+					vertices[s] += render_block_full_merged(
+									   d + s, pos[0], pos[1], pos[2], width,
+									   height, (enum side)s, (key >> 16) & 0xFF,
+									   (key >> 8) & 0xFF, key & 0xFF,
+									   count_only)
+						* 4;
 
-					light_data[BLK_INDEX(x, y, z) * 3 + 1]
-						= (sum_torch << 4) | sum_sky;
+					stats->merged_faces += width * height;
+					stats->merged_quads++;
 				}
+			}
+		}
+	}
+}
+#endif
 
-				if(x != CHUNK_SIZE + 1 && y != CHUNK_SIZE + 1) {
-					struct block_data b3[4] = {
-						BLK_DATA(bd, x + 0, y + 0, z - 1),
-						BLK_DATA(bd, x - 1, y + 0, z - 1),
-						BLK_DATA(bd, x + 0, y - 1, z - 1),
-						BLK_DATA(bd, x - 1, y - 1, z - 1),
-					};
+static bool chunk_mesher_face_visible(struct block_info* local,
+									  struct block_info* neighbour,
+									  enum side s) {
+	assert(local && neighbour);
+
+	enum side opposite = blocks_side_opposite(s);
+	uint8_t id_a
+		= blocks_side_mask[local->block->type][local->block->metadata][s];
+	uint8_t id_b = blocks_side_mask[neighbour->block->type]
+								   [neighbour->block->metadata][opposite];
+
+	if(id_a && id_b)
+		return (blocks_mask_visible[id_a] >> id_b) & 1;
+
+	// shape depends on the surroundings
+	return face_occlusion_test(
+		blocks[local->block->type]->getSideMask(local, s, neighbour),
+		blocks[neighbour->block->type]->getSideMask(neighbour, opposite,
+													local));
+}
 
-					int sum_sky = 0, sum_torch = 0, count = 0;
-					for(int k = 0; k < 4; k++) {
-						if(!blocks[b3[k].type]
-						   || (blocks[b3[k].type]->can_see_through
-							   && !blocks[b3[k].type]->ignore_lighting)) {
-							sum_sky += b3[k].sky_light;
-							sum_torch += b3[k].torch_light;
-							count++;
-						}
-					}
+// bit x + 1 of row [y + 1][z + 1] is set for full opaque blocks
+typedef uint32_t chunk_opacity_t[CHUNK_SIZE + 2][CHUNK_SIZE + 2];
+
+static void chunk_mesher_opacity(struct block_data* bd,
+								 chunk_opacity_t opaque) {
+	assert(bd && opaque);
+
+	for(int y = 0; y < CHUNK_SIZE + 2; y++) {
+		for(int z = 0; z < CHUNK_SIZE + 2; z++) {
+			struct block_data* row = bd + BLK_INDEX(0, y, z);
+			uint32_t bits = 0;
+
+			for(int x = 0; x < CHUNK_SIZE + 2; x++)
+				bits |= (uint32_t)blocks_full_opaque[row[x].type] << x;
+
+			opaque[y][z] = bits;
+		}
+	}
+}
+
+/* per side, bit x is set if block (x, y, z) and its neighbour on that side are
+ * both full opaque, which always hides the face between them */
+static void chunk_mesher_hidden_faces(chunk_opacity_t opaque, c_coord_t y,
+									  c_coord_t z, uint32_t* hidden) {
+	assert(opaque && hidden);
+
+	uint32_t row = opaque[y + 1][z + 1];
+
+	hidden[SIDE_LEFT] = (row & (row << 1)) >> 1;
+	hidden[SIDE_RIGHT] = (row & (row >> 1)) >> 1;
+	hidden[SIDE_BOTTOM] = (row & opaque[y][z + 1]) >> 1;
+	hidden[SIDE_TOP] = (row & opaque[y + 2][z + 1]) >> 1;
+	hidden[SIDE_FRONT] = (row & opaque[y + 1][z]) >> 1;
+	hidden[SIDE_BACK] = (row & opaque[y + 1][z + 2]) >> 1;
+}
+
+// blocks with a cube shape, everything else is left out of reduced meshes
+static bool chunk_mesher_lod_block(uint8_t type) {
+	return blocks[type]
+		&& (blocks[type]->renderBlock == render_block_full
+			|| blocks[type]->renderBlock == render_block_fluid);
+}
+
+static bool chunk_mesher_lod_edge(c_coord_t x, c_coord_t y, c_coord_t z) {
+	return x == 0 || x == CHUNK_SIZE - 1 || y == 0 || y == CHUNK_SIZE - 1
+		|| z == 0 || z == CHUNK_SIZE - 1;
+}
+
+/* Replaces each 2x2x2 cell by its dominant cube block if at least half of it
+ * is filled, or by air otherwise. Cube blocks on the chunk boundary are kept
+ * in air cells, so that a full detail neighbour never hides a face against a
+ * block that is missing here. The border of neighbours stays as it is. */
+static void chunk_mesher_downsample(struct block_data* bd) {
+	assert(bd);
+
+	for(c_coord_t y = 0; y < CHUNK_SIZE; y += 2) {
+		for(c_coord_t z = 0; z < CHUNK_SIZE; z += 2) {
+			for(c_coord_t x = 0; x < CHUNK_SIZE; x += 2) {
+				struct block_data* cell[8];
+				int count[8];
+				int filled = 0, dominant = -1;
+				uint8_t sky = 0, torch = 0;
+
+				for(int k = 0; k < 8; k++) {
+					cell[k] = &BLK_DATA(bd, x + (k & 1), y + (k >> 2),
+										z + ((k >> 1) & 1));
+					if(cell[k]->sky_light > sky)
+						sky = cell[k]->sky_light;
+					if(cell[k]->torch_light > torch)
+						torch = cell[k]->torch_light;
+					count[k] = 0;
+
+					if(!chunk_mesher_lod_block(cell[k]->type))
+						continue;
+
+					filled++;
+
+					// counted at the first block of the same type
+					int first = 0;
+					while(cell[first]->type != cell[k]->type)
+						first++;
+
+					count[first]++;
+
+					if(dominant < 0 || count[first] > count[dominant])
+						dominant = first;
+				}
 
-					sum_torch = count > 0 ? (sum_torch + count - 1) / count : 0;
-					sum_sky = count > 0 ? (sum_sky + count - 1) / count : 0;
-					sum_torch = MAX(sum_torch - shade_table[count], 0);
-					sum_sky = MAX(sum_sky - shade_table[count], 0);
+				struct block_data fill = (filled >= 4) ?
+					*cell[dominant] :
+					(struct block_data) {.type = BLOCK_AIR};
+
+				for(int k = 0; k < 8; k++) {
+					if(filled < 4 && chunk_mesher_lod_block(cell[k]->type)
+					   && chunk_mesher_lod_edge(x + (k & 1), y + (k >> 2),
+												z + ((k >> 1) & 1))) {
+						cell[k]->sky_light = sky;
+						cell[k]->torch_light = torch;
+						continue;
+					}
 
-					light_data[BLK_INDEX(x, y, z) * 3 + 2]
-						= (sum_torch << 4) | sum_sky;
+					*cell[k] = fill;
+					cell[k]->sky_light = sky;
+					cell[k]->torch_light = torch;
 				}
 			}
 		}
@@ -264,20 +545,34 @@ static void chunk_mesher_vertex_light(struct block_data* bd,
 static void chunk_mesher_rebuild(struct block_data* bd, w_coord_t cx,
 								 w_coord_t cy, w_coord_t cz,
 								 struct displaylist* d, bool count_only,
-								 size_t* vertices) {
-	assert(bd && d && vertices);
+								 size_t* vertices, uint8_t** light_cache,
+								 struct chunk_mesher_stats* stats) {
+	assert(bd && d && vertices && light_cache && stats);
 
-	uint8_t* light_data = NULL;
+	// computed on first use, kept by the caller for a following pass
+	uint8_t* light_data = *light_cache;
+	// greedy merge candidates, one key per face and side
+	uint32_t* faces = NULL;
 
 	for(int k = 0; k < 13; k++)
 		vertices[k] = 0;
 
+	chunk_opacity_t opaque;
+	chunk_mesher_opacity(bd, opaque);
+
 	for(c_coord_t y = 0; y < CHUNK_SIZE; y++) {
 		for(c_coord_t z = 0; z < CHUNK_SIZE; z++) {
+			uint32_t hidden[SIDE_MAX];
+			chunk_mesher_hidden_faces(opaque, y, z, hidden);
+
+			// fully enclosed blocks are never looked at
+			uint32_t buried = hidden[0] & hidden[1] & hidden[2] & hidden[3]
+				& hidden[4] & hidden[5];
+
 			for(c_coord_t x = 0; x < CHUNK_SIZE; x++) {
 				struct block_data local = BLK_DATA(bd, x, y, z);
 
-				if(blocks[local.type]) {
+				if(blocks[local.type] && !((buried >> x) & 1)) {
 					struct block_data neighbours[6];
 					struct block_info neighbours_info[6];
 
@@ -307,26 +602,22 @@ static void chunk_mesher_rebuild(struct block_data* bd, w_coord_t cx,
 					};
 
 					uint8_t vertex_light[24];
-					bool light_loaded = count_only;
+					bool mergeable = chunk_mesher_mergeable(blocks[local.type]);
+					bool light_loaded = count_only && !mergeable;
 
 					for(int k = 0; k < SIDE_MAX; k++) {
 						enum side s = (enum side)k;
 
 						bool face_visible = true;
 
-						if(blocks[neighbours[k].type]
+						if((hidden[k] >> x) & 1) {
+							face_visible = false;
+						} else if(blocks[neighbours[k].type]
 						   && ((!blocks[local.type]->transparent
 								&& !blocks[neighbours[k].type]->transparent)
 							   || blocks[local.type]->transparent)) {
-							struct face_occlusion* a
-								= blocks[local.type]->getSideMask(
-									&local_info, s, neighbours_info + k);
-							struct face_occlusion* b
-								= blocks[neighbours[k].type]->getSideMask(
-									neighbours_info + k,
-									blocks_side_opposite(s), &local_info);
-
-							face_visible = face_occlusion_test(a, b);
+							face_visible = chunk_mesher_face_visible(
+								&local_info, neighbours_info + k, s);
 						}
 
 						int dp_index = k;
@@ -349,106 +640,82 @@ static void chunk_mesher_rebuild(struct block_data* bd, w_coord_t cx,
 
 							if(!light_loaded) {
 								light_loaded = true;
-								vertex_light[0]
-									= light_data[BLK_INDEX(x + 0, y + 0, z + 0)
-													 * 3
-												 + 0];
-								vertex_light[1]
-									= light_data[BLK_INDEX(x + 1, y + 0, z + 0)
-													 * 3
-												 + 0];
-								vertex_light[2]
-									= light_data[BLK_INDEX(x + 1, y + 0, z + 1)
-													 * 3
-												 + 0];
-								vertex_light[3]
-									= light_data[BLK_INDEX(x + 0, y + 0, z + 1)
-													 * 3
-												 + 0];
-								vertex_light[4]
-									= light_data[BLK_INDEX(x + 0, y + 2, z + 0)
-													 * 3
-												 + 0];
-								vertex_light[5]
-									= light_data[BLK_INDEX(x + 1, y + 2, z + 0)
-													 * 3
-												 + 0];
-								vertex_light[6]
-									= light_data[BLK_INDEX(x + 1, y + 2, z + 1)
-													 * 3
-												 + 0];
-								vertex_light[7]
-									= light_data[BLK_INDEX(x + 0, y + 2, z + 1)
-													 * 3
-												 + 0];
-
-								vertex_light[8]
-									= light_data[BLK_INDEX(x + 0, y + 0, z + 0)
-													 * 3
-												 + 1];
-								vertex_light[9]
-									= light_data[BLK_INDEX(x + 0, y + 1, z + 0)
-													 * 3
-												 + 1];
-								vertex_light[10]
-									= light_data[BLK_INDEX(x + 0, y + 1, z + 1)
-													 * 3
-												 + 1];
-								vertex_light[11]
-									= light_data[BLK_INDEX(x + 0, y + 0, z + 1)
-													 * 3
-												 + 1];
-								vertex_light[12]
-									= light_data[BLK_INDEX(x + 2, y + 0, z + 0)
-													 * 3
-												 + 1];
-								vertex_light[13]
-									= light_data[BLK_INDEX(x + 2, y + 1, z + 0)
-													 * 3
-												 + 1];
-								vertex_light[14]
-									= light_data[BLK_INDEX(x + 2, y + 1, z + 1)
-													 * 3
-												 + 1];
-								vertex_light[15]
-									= light_data[BLK_INDEX(x + 2, y + 0, z + 1)
-													 * 3
-												 + 1];
-
-								vertex_light[16]
-									= light_data[BLK_INDEX(x + 0, y + 0, z + 0)
-													 * 3
-												 + 2];
-								vertex_light[17]
-									= light_data[BLK_INDEX(x + 1, y + 0, z + 0)
-													 * 3
-												 + 2];
-								vertex_light[18]
-									= light_data[BLK_INDEX(x + 1, y + 1, z + 0)
-													 * 3
-												 + 2];
-								vertex_light[19]
-									= light_data[BLK_INDEX(x + 0, y + 1, z + 0)
-													 * 3
-												 + 2];
-								vertex_light[20]
-									= light_data[BLK_INDEX(x + 0, y + 0, z + 2)
-													 * 3
-												 + 2];
-								vertex_light[21]
-									= light_data[BLK_INDEX(x + 1, y + 0, z + 2)
-													 * 3
-												 + 2];
-								vertex_light[22]
-									= light_data[BLK_INDEX(x + 1, y + 1, z + 2)
-													 * 3
-												 + 2];
-								vertex_light[23]
-									= light_data[BLK_INDEX(x + 0, y + 1, z + 2)
-													 * 3
-												 + 2];
+								vertex_light[0] = LIGHT_DATA(
+									light_data, 0, x + 0, y + 0, z + 0);
+								vertex_light[1] = LIGHT_DATA(
+									light_data, 0, x + 1, y + 0, z + 0);
+								vertex_light[2] = LIGHT_DATA(
+									light_data, 0, x + 1, y + 0, z + 1);
+								vertex_light[3] = LIGHT_DATA(
+									light_data, 0, x + 0, y + 0, z + 1);
+								vertex_light[4] = LIGHT_DATA(
+									light_data, 0, x + 0, y + 2, z + 0);
+								vertex_light[5] = LIGHT_DATA(
+									light_data, 0, x + 1, y + 2, z + 0);
+								vertex_light[6] = LIGHT_DATA(
+									light_data, 0, x + 1, y + 2, z + 1);
+								vertex_light[7] = LIGHT_DATA(
+									light_data, 0, x + 0, y + 2, z + 1);
+
+								vertex_light[8] = LIGHT_DATA(
+									light_data, 1, x + 0, y + 0, z + 0);
+								vertex_light[9] = LIGHT_DATA(
+									light_data, 1, x + 0, y + 1, z + 0);
+								vertex_light[10] = LIGHT_DATA(
+									light_data, 1, x + 0, y + 1, z + 1);
+								vertex_light[11] = LIGHT_DATA(
+									light_data, 1, x + 0, y + 0, z + 1);
+								vertex_light[12] = LIGHT_DATA(
+									light_data, 1, x + 2, y + 0, z + 0);
+								vertex_light[13] = LIGHT_DATA(
+									light_data, 1, x + 2, y + 1, z + 0);
+								vertex_light[14] = LIGHT_DATA(
+									light_data, 1, x + 2, y + 1, z + 1);
+								vertex_light[15] = LIGHT_DATA(
+									light_data, 1, x + 2, y + 0, z + 1);
+
+								vertex_light[16] = LIGHT_DATA(
+									light_data, 2, x + 0, y + 0, z + 0);
+								vertex_light[17] = LIGHT_DATA(
+									light_data, 2, x + 1, y + 0, z + 0);
+								vertex_light[18] = LIGHT_DATA(
+									light_data, 2, x + 1, y + 1, z + 0);
+								vertex_light[19] = LIGHT_DATA(
+									light_data, 2, x + 0, y + 1, z + 0);
+								vertex_light[20] = LIGHT_DATA(
+									light_data, 2, x + 0, y + 0, z + 2);
+								vertex_light[21] = LIGHT_DATA(
+									light_data, 2, x + 1, y + 0, z + 2);
+								vertex_light[22] = LIGHT_DATA(
+									light_data, 2, x + 1, y + 1, z + 2);
+								vertex_light[23] = LIGHT_DATA(
+									light_data, 2, x + 0, y + 1, z + 2);
+							}
+						}
+
+#ifdef DISPLAYLIST_TEXCOORD_REPEAT
+						const uint8_t* fl = vertex_light + side_light_offset[k];
+
+						if(face_visible && mergeable && fl[0] == fl[1]
+						   && fl[0] == fl[2] && fl[0] == fl[3]) {
+							if(!faces) {
+								faces = calloc(SIDE_MAX * CHUNK_SIZE
+												   * CHUNK_SIZE * CHUNK_SIZE,
+											   sizeof(uint32_t));
+								assert(faces);
 							}
+
+							c_coord_t pos[3] = {x, y, z};
+							faces[GREEDY_INDEX(k, pos[greedy_axes[k][0]],
+											   pos[greedy_axes[k][1]],
+											   pos[greedy_axes[k][2]])]
+								= GREEDY_KEY(
+									blocks[local.type]->getTextureIndex(
+										&local_info, s),
+									blocks[local.type]->luminance, fl[0]);
+							continue;
 						}
+#endif
 
 						if(face_visible)
 							vertices[dp_index]
@@ -471,39 +738,130 @@ static void chunk_mesher_rebuild(struct block_data* bd, w_coord_t cx,
 		}
 	}
 
-	if(light_data)
-		free(light_data);
+#ifdef DISPLAYLIST_TEXCOORD_REPEAT
+	if(faces) {
+		chunk_mesher_greedy(faces, d, count_only, vertices, stats);
+		free(faces);
+	}
+#endif
+
+	*light_cache = light_data;
 }
 
-static void chunk_mesher_build(struct chunk_mesher_rpc* req) {
-	for(int k = 0; k < 13; k++) {
-		req->result.has_displist[k] = false;
-		displaylist_init(req->result.mesh + k, 64, 3 * 2 + 2 * 1 + 1);
+static void chunk_mesher_build(struct chunk_mesher_rpc* req,
+							   const char* cache_dir) {
+	uint64_t hash = 0;
+	req->result.cached = false;
+
+	if(cache_dir) {
+		hash = mesh_cache_hash(req->request.blocks);
+
+		if(mesh_cache_read(cache_dir, req->chunk->x, req->chunk->y,
+						   req->chunk->z, req->request.lod, hash,
+						   &req->result)) {
+			req->result.cached = true;
+			return;
+		}
+	}
+
+	// connectivity always follows the full detail blocks
+	if(req->request.opaque) {
+		memset(req->result.reachable, 0, sizeof(req->result.reachable));
+	} else {
+		chunk_mesher_reachable(req->request.blocks, req->result.reachable);
 	}
 
+	if(req->request.lod)
+		chunk_mesher_downsample(req->request.blocks);
+
+	uint8_t* light_data = NULL;
+	size_t counted[13];
+	struct chunk_mesher_stats count_stats = {0};
+	struct displaylist writers[13];
+
+	// count first, so that all 13 lists fit into a single exact allocation
+	chunk_mesher_rebuild(req->request.blocks, req->chunk->x, req->chunk->y,
+						 req->chunk->z, writers, true, counted, &light_data,
+						 &count_stats);
+
+	displaylist_batch_init(&req->result.mesh, 13, counted,
+						   CHUNK_MESHER_VERTEX_SIZE);
+
+	for(int k = 0; k < 13; k++)
+		displaylist_batch_writer(&req->result.mesh, k, writers + k);
+
+	req->result.stats = (struct chunk_mesher_stats) {0};
+
 	size_t vertices[13];
 	chunk_mesher_rebuild(req->request.blocks, req->chunk->x, req->chunk->y,
-						 req->chunk->z, req->result.mesh, false, vertices);
+						 req->chunk->z, writers, false, vertices, &light_data,
+						 &req->result.stats);
+
+	if(light_data)
+		free(light_data);
+
+	displaylist_batch_finalize(&req->result.mesh, writers);
+	req->result.has_mesh = false;
 
 	for(int k = 0; k < 13; k++) {
-		if(vertices[k] > 0 && vertices[k] <= 0xFFFF * 4) {
-			displaylist_finalize(req->result.mesh + k, vertices[k]);
-			req->result.has_displist[k] = true;
-		} else {
-			displaylist_destroy(req->result.mesh + k);
+		assert(vertices[k] == counted[k]);
+		req->result.has_displist[k]
+			= vertices[k] > 0 && vertices[k] <= 0xFFFF * 4;
+
+		if(req->result.has_displist[k]) {
+			req->result.has_mesh = true;
+			req->result.stats.vertices += vertices[k];
 		}
 	}
 
-	chunk_test_init(req->request.blocks, req->result.reachable);
+	if(req->result.has_mesh) {
+		req->result.stats.bytes = displaylist_batch_bytes(&req->result.mesh);
+		req->result.stats.saved = displaylist_batch_saved(&req->result.mesh);
+	} else {
+		displaylist_batch_destroy(&req->result.mesh);
+	}
+
+	if(cache_dir && req->request.cache)
+		mesh_cache_write(cache_dir, req->chunk->x, req->chunk->y,
+						 req->chunk->z, req->request.lod, hash, &req->result);
+}
+
+void chunk_mesher_build_snapshot(struct chunk* c, struct block_data* blocks,
+								 struct chunk_mesher_stats* stats) {
+	assert(c && blocks && stats);
+
+	struct chunk_mesher_rpc req = (struct chunk_mesher_rpc) {
+		.chunk = c,
+		.request.blocks = blocks,
+		.request.opaque = c->opaque == CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE,
+		.request.lod = c->lod,
+	};
+
+	chunk_mesher_build(&req, NULL);
+	free(blocks);
+	*stats = req.result.stats;
 
-	free(req->request.blocks);
+	if(req.result.has_mesh)
+		displaylist_batch_destroy(&req.result.mesh);
 }
 
 static void* chunk_mesher_local_thread(void* user) {
 	while(1) {
-		struct chunk_mesher_rpc* request;
-		tchannel_receive(&mesher_requests, (void**)&request, true);
-		chunk_mesher_build(request);
+		void* token;
+		tchannel_receive(&mesher_requests, &token, true);
+
+		char cache_dir[sizeof(mesher_cache_dir)];
+
+		tmutex_lock(&request_heap_lock);
+		struct chunk_mesher_rpc* request = request_heap_pop();
+		request->queued = false;
+		strcpy(cache_dir, mesher_cache_dir);
+		tmutex_unlock(&request_heap_lock);
+
+		request->request.blocks = pool_alloc(&snapshot_pool);
+		chunk_pin_snapshot(&request->request.pin, request->request.blocks);
+		chunk_mesher_build(request, *cache_dir ? cache_dir : NULL);
+		pool_free(&snapshot_pool, request->request.blocks);
 		tchannel_send(&mesher_results, request, true);
 	}
 
@@ -511,66 +869,252 @@ static void* chunk_mesher_local_thread(void* user) {
 }
 
 void chunk_mesher_init() {
-	tchannel_init(&mesher_requests, CHUNK_MESHER_QLENGTH);
-	tchannel_init(&mesher_results, CHUNK_MESHER_QLENGTH);
-	tchannel_init(&mesher_empty_msg, CHUNK_MESHER_QLENGTH);
+	int workers = config_read_int(&gstate.config_user, "mesher.threads", 0);
+	mesher_workers = workers > 0 ? (size_t)workers :
+								   thread_hardware_concurrency();
+
+	rpc_msg_length = CHUNK_MESHER_QLENGTH * mesher_workers;
+	rpc_msg = malloc(rpc_msg_length * sizeof(struct chunk_mesher_rpc));
+	request_heap = malloc(rpc_msg_length * sizeof(struct chunk_mesher_rpc*));
+	assert(rpc_msg && request_heap);
+
+	request_heap_size = 0;
+	tmutex_init(&request_heap_lock);
+
+	// snapshots are only taken by the workers, one at a time
+	pool_create(&snapshot_pool,
+				(CHUNK_SIZE + 2) * (CHUNK_SIZE + 2) * (CHUNK_SIZE + 2)
+					* sizeof(struct block_data),
+				mesher_workers);
+
+#ifdef PLATFORM_WII
+	// sd card access is slower than meshing
+	mesher_cache_enabled
+		= config_read_int(&gstate.config_user, "mesher.disk_cache", 0);
+#else
+	mesher_cache_enabled
+		= config_read_int(&gstate.config_user, "mesher.disk_cache", 1);
+#endif
+
+	tchannel_init(&mesher_requests, rpc_msg_length);
+	tchannel_init(&mesher_results, rpc_msg_length);
+	tchannel_init(&mesher_empty_msg, rpc_msg_length);
 
-	for(int k = 0; k < CHUNK_MESHER_QLENGTH; k++)
+	for(size_t k = 0; k < rpc_msg_length; k++)
 		tchannel_send(&mesher_empty_msg, rpc_msg + k, true);
 
-	struct thread t;
-	thread_create(&t, chunk_mesher_local_thread, NULL, 4);
+	for(size_t k = 0; k < mesher_workers; k++) {
+		struct thread t;
+		thread_create(&t, chunk_mesher_local_thread, NULL, 4);
+	}
+
+	log_info("Chunk mesher: %zu worker(s)", mesher_workers);
+}
+
+size_t chunk_mesher_capacity() {
+	return rpc_msg_length;
+}
+
+static void chunk_mesher_account(struct chunk_mesher_stats* s, bool add) {
+	assert(s);
+
+	if(add) {
+		mesher_stats.vertices += s->vertices;
+		mesher_stats.bytes += s->bytes;
+		mesher_stats.saved += s->saved;
+		mesher_stats.merged_faces += s->merged_faces;
+		mesher_stats.merged_quads += s->merged_quads;
+	} else {
+		mesher_stats.vertices -= s->vertices;
+		mesher_stats.bytes -= s->bytes;
+		mesher_stats.saved -= s->saved;
+		mesher_stats.merged_faces -= s->merged_faces;
+		mesher_stats.merged_quads -= s->merged_quads;
+	}
+}
+
+void chunk_mesher_release(struct chunk* c) {
+	assert(c);
+	chunk_mesher_account(&c->mesh_stats, false);
+	c->mesh_stats = (struct chunk_mesher_stats) {0};
+}
+
+void chunk_mesher_get_stats(struct chunk_mesher_stats* stats) {
+	assert(stats);
+	*stats = mesher_stats;
+}
+
+void chunk_mesher_get_pool_stats(struct pool_stats* stats) {
+	assert(stats);
+	pool_get_stats(&snapshot_pool, stats);
+}
+
+void chunk_mesher_set_world(const char* world_dir) {
+	char dir[sizeof(mesher_cache_dir)] = "";
+
+	if(mesher_cache_enabled && world_dir) {
+		snprintf(dir, sizeof(dir), "%s/meshcache", world_dir);
+#ifdef _WIN32
+		mkdir(dir);
+#else
+		mkdir(dir, 0755);
+#endif
+	}
+
+	tmutex_lock(&request_heap_lock);
+	strcpy(mesher_cache_dir, dir);
+	tmutex_unlock(&request_heap_lock);
 }
 
 void chunk_mesher_receive() {
 	struct chunk_mesher_rpc* result;
 
 	while(tchannel_receive(&mesher_results, (void**)&result, false)) {
-		for(int k = 0; k < 13; k++) {
-			if(result->chunk->has_displist[k])
-				displaylist_destroy(result->chunk->mesh + k);
+		struct chunk* c = result->chunk;
+
+		if(c->mesh_request == result)
+			c->mesh_request = NULL;
+
+		// a newer snapshot is still being meshed, keep the old mesh until then
+		if(result->generation != c->mesh_generation) {
+			if(result->result.has_mesh)
+				displaylist_batch_destroy(&result->result.mesh);
 
-			result->chunk->mesh[k] = result->result.mesh[k];
-			result->chunk->has_displist[k] = result->result.has_displist[k];
+			mesher_stats.superseded++;
+			chunk_unpin(&result->request.pin);
+			chunk_unref(c);
+			tchannel_send(&mesher_empty_msg, result, true);
+			continue;
 		}
 
+		chunk_mesher_release(c);
+		c->mesh_stats = result->result.stats;
+
+		if(result->result.cached)
+			mesher_stats.cache_hits++;
+
+		chunk_mesher_account(&c->mesh_stats, true);
+
+		if(c->has_mesh)
+			displaylist_batch_destroy(&c->mesh);
+
+		c->mesh = result->result.mesh;
+		c->has_mesh = result->result.has_mesh;
+
+		for(int k = 0; k < 13; k++)
+			c->has_displist[k] = result->result.has_displist[k];
+
 		for(int k = 0; k < 6; k++)
-			result->chunk->reachable[k] = result->result.reachable[k];
+			c->reachable[k] = result->result.reachable[k];
 
-		chunk_unref(result->chunk);
+		chunk_unpin(&result->request.pin);
+		chunk_unref(c);
 
 		tchannel_send(&mesher_empty_msg, result, true);
 	}
 }
 
-bool chunk_mesher_send(struct chunk* c) {
+// swaps in a new pin if the last request of c was not picked up yet
+static bool chunk_mesher_replace(struct chunk* c) {
+	assert(c);
+
+	if(!c->mesh_request)
+		return false;
+
+	struct chunk_pin pin;
+	chunk_pin(c, &pin);
+
+	tmutex_lock(&request_heap_lock);
+	struct chunk_mesher_rpc* request = c->mesh_request;
+	bool queued = request->queued;
+
+	if(queued) {
+		struct chunk_pin old = request->request.pin;
+		request->request.pin = pin;
+		request->request.opaque
+			= c->opaque == CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+		request->request.lod = c->lod;
+		request->request.cache = !c->mesh_edited;
+		request->generation = ++c->mesh_generation;
+		pin = old;
+	}
+
+	tmutex_unlock(&request_heap_lock);
+
+	chunk_unpin(&pin);
+
+	if(queued)
+		mesher_stats.coalesced++;
+
+	return queued;
+}
+
+/* chunks that are all air or enclosed by opaque blocks have an empty mesh,
+ * the result is passed through mesher_results so that it is applied at the
+ * same point as all others */
+static bool chunk_mesher_send_empty(struct chunk* c, uint8_t reachable) {
 	assert(c);
 
 	struct chunk_mesher_rpc* request;
 	if(!tchannel_receive(&mesher_empty_msg, (void**)&request, false))
 		return false;
 
-	struct block_data* bd
-		= malloc((CHUNK_SIZE + 2) * (CHUNK_SIZE + 2) * (CHUNK_SIZE + 2)
-				 * sizeof(struct block_data));
+	chunk_ref(c);
+
+	request->chunk = c;
+	request->generation = ++c->mesh_generation;
+	request->queued = false;
+	request->request.pin = (struct chunk_pin) {0};
+	request->result.has_mesh = false;
+	request->result.cached = false;
+	request->result.stats = (struct chunk_mesher_stats) {0};
+
+	for(int k = 0; k < 13; k++)
+		request->result.has_displist[k] = false;
+
+	for(int k = 0; k < 6; k++)
+		request->result.reachable[k] = reachable;
+
+	c->mesh_request = request;
+	mesher_stats.skipped++;
+
+	tchannel_send(&mesher_results, request, true);
+	return true;
+}
+
+bool chunk_mesher_send(struct chunk* c, struct chunk_mesher_priority priority) {
+	assert(c);
+
+	if(!c->non_air)
+		return chunk_mesher_send_empty(c, (1 << SIDE_MAX) - 1);
 
-	if(!bd) {
-		tchannel_send(&mesher_empty_msg, request, true);
+	if(chunk_enclosed(c))
+		return chunk_mesher_send_empty(c, 0);
+
+	if(chunk_mesher_replace(c))
+		return true;
+
+	struct chunk_mesher_rpc* request;
+	if(!tchannel_receive(&mesher_empty_msg, (void**)&request, false))
 		return false;
-	}
 
 	chunk_ref(c);
 
 	request->chunk = c;
-	request->request.blocks = bd;
-
-	for(w_coord_t y = -1; y < CHUNK_SIZE + 1; y++) {
-		for(w_coord_t z = -1; z < CHUNK_SIZE + 1; z++) {
-			for(w_coord_t x = -1; x < CHUNK_SIZE + 1; x++) {
-				BLK_DATA(bd, x, y, z) = chunk_lookup_block(c, x, y, z);
-			}
-		}
-	}
+	request->generation = ++c->mesh_generation;
+	request->queued = true;
+	request->request.opaque
+		= c->opaque == CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+	request->request.lod = c->lod;
+	request->request.cache = !c->mesh_edited;
+	request->request.priority = priority;
+	c->mesh_request = request;
+
+	chunk_pin(c, &request->request.pin);
+
+	tmutex_lock(&request_heap_lock);
+	request_heap_push(request);
+	tmutex_unlock(&request_heap_lock);
 
 	tchannel_send(&mesher_requests, request, true);
 	return true;
@@ -21,13 +21,65 @@
 #define CHUNK_MESHER_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
+#include "platform/displaylist.h"
+#include "pool.h"
+
+// per worker thread
 #define CHUNK_MESHER_QLENGTH 8
+// bump whenever the mesh output for the same blocks changes
+#define CHUNK_MESHER_VERSION 1
+#define CHUNK_MESHER_VERTEX_SIZE (3 * 2 + 2 * 1 + 1)
 
 struct chunk;
+struct block_data;
+
+struct chunk_mesher_priority {
+	bool visible;
+	float distance;
+};
+
+struct chunk_mesher_stats {
+	size_t vertices;
+	size_t bytes;
+	// over growing each list on demand, see displaylist_batch_saved()
+	size_t saved;
+	// full cube faces folded into greedy quads
+	size_t merged_faces;
+	size_t merged_quads;
+	// results dropped because a newer snapshot was sent meanwhile
+	size_t superseded;
+	// snapshots swapped into a request that was still queued
+	size_t coalesced;
+	// all air or enclosed chunks, not sent to a worker
+	size_t skipped;
+	// meshes read back from the on-disk cache
+	size_t cache_hits;
+};
+
+struct chunk_mesher_result {
+	struct displaylist_batch mesh;
+	bool has_mesh;
+	bool has_displist[13];
+	uint8_t reachable[6];
+	struct chunk_mesher_stats stats;
+	bool cached;
+};
 
 void chunk_mesher_init(void);
+size_t chunk_mesher_capacity(void);
 void chunk_mesher_receive(void);
-bool chunk_mesher_send(struct chunk* c);
+bool chunk_mesher_send(struct chunk* c, struct chunk_mesher_priority priority);
+void chunk_mesher_release(struct chunk* c);
+void chunk_mesher_get_stats(struct chunk_mesher_stats* stats);
+void chunk_mesher_get_pool_stats(struct pool_stats* stats);
+void chunk_mesher_set_world(const char* world_dir);
+// meshes a chunk_snapshot() of c on the calling thread, frees blocks
+void chunk_mesher_build_snapshot(struct chunk* c, struct block_data* blocks,
+								 struct chunk_mesher_stats* stats);
+// sides that see each other through a chunk_snapshot(), one bitset per side
+void chunk_mesher_reachable(struct block_data* blocks, uint8_t* reachable);
 
 #endif
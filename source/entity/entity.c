@@ -65,6 +65,16 @@ bool entity_get_block(struct entity* e, w_coord_t x, w_coord_t y, w_coord_t z,
 	}
 }
 
+void entity_resolve_volume(struct entity* e, struct block_volume* v) {
+	assert(e && v);
+
+	if(e->on_server) {
+		server_world_resolve_volume(e->world, v);
+	} else {
+		world_resolve_volume(e->world, v);
+	}
+}
+
 void entity_shadow(struct entity* e, struct AABB* a, mat4 view) {
 	assert(e && a && view);
 
@@ -86,12 +96,16 @@ void entity_shadow(struct entity* e, struct AABB* a, mat4 view) {
 	float du = 1.0F / (a->x2 - a->x1);
 	float dv = 1.0F / (a->z2 - a->z1);
 
+	struct block_volume vol;
+	block_volume_init(&vol, min_x, min_y, min_z, max_x, max_y, max_z);
+	entity_resolve_volume(e, &vol);
+
 	for(w_coord_t x = min_x; x < max_x; x++) {
 		for(w_coord_t z = min_z; z < max_z; z++) {
 			for(w_coord_t y = min_y; y < max_y; y++) {
-				struct block_data blk;
+				struct block_data blk = *block_volume_get(&vol, x, y, z);
 
-				if(entity_get_block(e, x, y, z, &blk) && blocks[blk.type]) {
+				if(blocks[blk.type]) {
 					struct block_info blk_info = (struct block_info) {
 						.block = &blk,
 						.neighbours = NULL,
@@ -137,6 +151,8 @@ void entity_shadow(struct entity* e, struct AABB* a, mat4 view) {
 		}
 	}
 
+	block_volume_destroy(&vol);
+
 	gfx_blending(MODE_OFF);
 	gfx_alpha_test(true);
 	gfx_lighting(true);
@@ -166,28 +182,52 @@ bool entity_block_aabb_test(struct AABB* entity, struct block_info* blk_info) {
 	return false;
 }
 
-bool entity_intersection(struct entity* e, struct AABB* a,
-						 bool (*test)(struct AABB* entity,
-									  struct block_info* blk_info)) {
-	assert(e && a && test);
-
-	w_coord_t min_x = floorf(a->x1);
+static void entity_intersection_range(struct AABB* a, w_coord_t* min_x,
+									  w_coord_t* min_y, w_coord_t* min_z,
+									  w_coord_t* max_x, w_coord_t* max_y,
+									  w_coord_t* max_z) {
+	*min_x = floorf(a->x1);
 	// need to look one further, otherwise fence block breaks
-	w_coord_t min_y = max((w_coord_t)(floorf(a->y1) - 1), 0);
-	w_coord_t min_z = floorf(a->z1);
+	*min_y = max((w_coord_t)(floorf(a->y1) - 1), 0);
+	*min_z = floorf(a->z1);
 
-	w_coord_t max_x = ceilf(a->x2) + 1;
-	w_coord_t max_y = min((w_coord_t)(ceilf(a->y2) + 1), WORLD_HEIGHT - 1);
-	w_coord_t max_z = ceilf(a->z2) + 1;
+	*max_x = ceilf(a->x2) + 1;
+	*max_y = min((w_coord_t)(ceilf(a->y2) + 1), WORLD_HEIGHT - 1);
+	*max_z = ceilf(a->z2) + 1;
+
+	// nothing to test above the world
+	*max_y = max(*max_y, *min_y);
+}
+
+void entity_volume_init(struct entity* e, struct block_volume* v,
+						struct AABB* a) {
+	assert(e && v && a);
+
+	w_coord_t min_x, min_y, min_z, max_x, max_y, max_z;
+	entity_intersection_range(a, &min_x, &min_y, &min_z, &max_x, &max_y,
+							  &max_z);
+
+	block_volume_init(v, min_x, min_y, min_z, max_x, max_y, max_z);
+	entity_resolve_volume(e, v);
+}
+
+bool entity_volume_intersection(struct block_volume* v, struct AABB* a,
+								bool (*test)(struct AABB* entity,
+											 struct block_info* blk_info)) {
+	assert(v && a && test);
+
+	w_coord_t min_x, min_y, min_z, max_x, max_y, max_z;
+	entity_intersection_range(a, &min_x, &min_y, &min_z, &max_x, &max_y,
+							  &max_z);
 
 	for(w_coord_t x = min_x; x < max_x; x++) {
 		for(w_coord_t z = min_z; z < max_z; z++) {
 			for(w_coord_t y = min_y; y < max_y; y++) {
-				struct block_data blk;
+				struct block_data* blk = block_volume_get(v, x, y, z);
 
-				if(entity_get_block(e, x, y, z, &blk) && blocks[blk.type]
+				if(blocks[blk->type]
 				   && test(a,
-						   &(struct block_info) {.block = &blk,
+						   &(struct block_info) {.block = blk,
 												 .neighbours = NULL,
 												 .x = x,
 												 .y = y,
@@ -200,6 +240,19 @@ bool entity_intersection(struct entity* e, struct AABB* a,
 	return false;
 }
 
+bool entity_intersection(struct entity* e, struct AABB* a,
+						 bool (*test)(struct AABB* entity,
+									  struct block_info* blk_info)) {
+	assert(e && a && test);
+
+	struct block_volume v;
+	entity_volume_init(e, &v, a);
+
+	bool res = entity_volume_intersection(&v, a, test);
+	block_volume_destroy(&v);
+	return res;
+}
+
 bool entity_aabb_intersection(struct entity* e, struct AABB* a) {
 	return entity_intersection(e, a, entity_block_aabb_test);
 }
@@ -209,13 +262,30 @@ bool entity_intersection_threshold(struct entity* e, struct AABB* aabb,
 								   float* threshold) {
 	assert(e && aabb && old_pos && new_pos && threshold);
 
-	struct AABB tmp = *aabb;
-	aabb_translate(&tmp, old_pos[0], old_pos[1], old_pos[2]);
-	bool a = entity_aabb_intersection(e, &tmp);
+	struct AABB box_old = *aabb;
+	aabb_translate(&box_old, old_pos[0], old_pos[1], old_pos[2]);
+
+	struct AABB box_new = *aabb;
+	aabb_translate(&box_new, new_pos[0], new_pos[1], new_pos[2]);
+
+	/* every box tested below lies between the old and new box, so a single
+	 * volume around both serves all tests */
+	w_coord_t min_x, min_y, min_z, max_x, max_y, max_z;
+	w_coord_t min_x2, min_y2, min_z2, max_x2, max_y2, max_z2;
+	entity_intersection_range(&box_old, &min_x, &min_y, &min_z, &max_x,
+							  &max_y, &max_z);
+	entity_intersection_range(&box_new, &min_x2, &min_y2, &min_z2, &max_x2,
+							  &max_y2, &max_z2);
 
-	tmp = *aabb;
-	aabb_translate(&tmp, new_pos[0], new_pos[1], new_pos[2]);
-	bool b = entity_aabb_intersection(e, &tmp);
+	struct block_volume v;
+	block_volume_init(&v, min(min_x, min_x2), min(min_y, min_y2),
+					  min(min_z, min_z2), max(max_x, max_x2),
+					  max(max_y, max_y2), max(max_z, max_z2));
+	entity_resolve_volume(e, &v);
+
+	bool a = entity_volume_intersection(&v, &box_old, entity_block_aabb_test);
+	bool b = entity_volume_intersection(&v, &box_new, entity_block_aabb_test);
+	bool res;
 
 	if(!a && b) {
 		float range_min = 0.0F;
@@ -237,7 +307,8 @@ bool entity_intersection_threshold(struct entity* e, struct AABB* aabb,
 			struct AABB dest = *aabb;
 			aabb_translate(&dest, pos_mid[0], pos_mid[1], pos_mid[2]);
 
-			if(entity_aabb_intersection(e, &dest)) {
+			if(entity_volume_intersection(&v, &dest,
+										  entity_block_aabb_test)) {
 				range_max = mid;
 			} else {
 				range_min = mid;
@@ -245,14 +316,17 @@ bool entity_intersection_threshold(struct entity* e, struct AABB* aabb,
 		}
 
 		*threshold = range_min;
-		return true;
+		res = true;
 	} else if(a) {
 		*threshold = 0.0F;
-		return true;
+		res = true;
 	} else {
 		*threshold = 1.0F;
-		return false;
+		res = false;
 	}
+
+	block_volume_destroy(&v);
+	return res;
 }
 
 void entity_try_move(struct entity* e, vec3 pos, vec3 vel, struct AABB* bbox,
@@ -89,6 +89,7 @@ void entity_shadow(struct entity* e, struct AABB* a, mat4 view);
 
 bool entity_get_block(struct entity* e, w_coord_t x, w_coord_t y, w_coord_t z,
 					  struct block_data* blk);
+void entity_resolve_volume(struct entity* e, struct block_volume* v);
 bool entity_intersection_threshold(struct entity* e, struct AABB* aabb,
 								   vec3 old_pos, vec3 new_pos,
 								   float* threshold);
@@ -96,6 +97,12 @@ bool entity_intersection(struct entity* e, struct AABB* a,
 						 bool (*test)(struct AABB* entity,
 									  struct block_info* blk_info));
 bool entity_block_aabb_test(struct AABB* entity, struct block_info* blk_info);
+// volume around the blocks entity_intersection() would test for a
+void entity_volume_init(struct entity* e, struct block_volume* v,
+						struct AABB* a);
+bool entity_volume_intersection(struct block_volume* v, struct AABB* a,
+								bool (*test)(struct AABB* entity,
+											 struct block_info* blk_info));
 bool entity_aabb_intersection(struct entity* e, struct AABB* a);
 void entity_try_move(struct entity* e, vec3 pos, vec3 vel, struct AABB* bbox,
 					 size_t coord, bool* collision_xz, bool* on_ground);
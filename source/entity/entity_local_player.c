@@ -70,8 +70,11 @@ static bool entity_tick(struct entity* e) {
 	aabb_translate(&bbox, e->pos[0], e->pos[1] + 1.8F / 2.0F - EYE_HEIGHT,
 				   e->pos[2]);
 
-	bool in_water = entity_intersection(e, &bbox, test_in_water);
-	bool in_lava = entity_intersection(e, &bbox, test_in_lava);
+	struct block_volume v;
+	entity_volume_init(e, &v, &bbox);
+	bool in_water = entity_volume_intersection(&v, &bbox, test_in_water);
+	bool in_lava = entity_volume_intersection(&v, &bbox, test_in_lava);
+	block_volume_destroy(&v);
 
 	float slipperiness
 		= (in_lava || in_water) ? 1.0F : (e->on_ground ? 0.6F : 1.0F);
@@ -0,0 +1,604 @@
+/*
+	Copyright (c) 2025 Lunna5
+
+	This file is part of CavEX.
+
+	CavEX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	CavEX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with CavEX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "block/blocks.h"
+#include "far_terrain.h"
+#include "game/game_state.h"
+#include "graphics/render_block.h"
+#include "graphics/texture_atlas.h"
+#include "network/region_archive.h"
+#include "network/server_local.h"
+#include "network/server_world.h"
+#include "platform/displaylist.h"
+#include "platform/gfx.h"
+#include "platform/texture.h"
+#include "platform/thread.h"
+#include "stack.h"
+#include "world.h"
+
+// columns per side of a quad
+#define FAR_CELL 4
+#define FAR_CELLS (CHUNK_SIZE / FAR_CELL)
+#define FAR_QLENGTH 16
+#define FAR_BLK_LEN 256
+// vertex heights are relative to this, to stay within int16_t
+#define FAR_ORIGIN_Y (WORLD_HEIGHT / 2)
+// innermost ring requested, closer columns are always loaded
+#define FAR_MIN_RING 2
+
+enum far_list {
+	FAR_LIST_SOLID,
+	// drawn with the water texture
+	FAR_LIST_FLUID,
+	FAR_LIST_MAX,
+};
+
+struct far_column {
+	// still being read by the worker
+	bool pending;
+	bool has_list[FAR_LIST_MAX];
+	struct displaylist list[FAR_LIST_MAX];
+	size_t bytes;
+};
+
+DICT_DEF2(dict_far, int64_t, M_BASIC_OPLIST, struct far_column, M_POD_OPLIST)
+
+struct far_terrain_rpc {
+	w_coord_t x, z;
+	uint32_t generation;
+	bool has_list[FAR_LIST_MAX];
+	struct displaylist list[FAR_LIST_MAX];
+	size_t bytes;
+};
+
+static struct far_terrain_rpc far_rpc[FAR_QLENGTH];
+static struct thread_channel far_requests;
+static struct thread_channel far_results;
+static struct thread_channel far_empty_msg;
+
+// world and generation are protected by far_lock, only written on main thread
+static struct thread_mutex far_lock;
+static char far_world_dir[256];
+static uint32_t far_generation;
+
+// only accessed by the main thread
+static dict_far_t far_columns;
+static int far_radius;
+static w_coord_t far_center_x, far_center_z;
+static int far_scan_ring, far_scan_index;
+static size_t far_pending;
+static size_t far_bytes;
+
+/* the server thread can move chunks within a region file at any time, so the
+ * header is read again for every column, only the file access is locked */
+static bool far_terrain_read(const char* dir, w_coord_t x, w_coord_t z,
+							 struct server_chunk* sc) {
+	assert(dir && sc);
+
+	string_t name;
+	string_init_set_str(name, dir);
+
+	region_archive_lock();
+
+	struct region_archive ra;
+	bool exists = false;
+	void* data = NULL;
+	size_t length = 0;
+	bool success = region_archive_create(&ra, name, CHUNK_REGION_COORD(x),
+										 CHUNK_REGION_COORD(z),
+										 WORLD_DIM_OVERWORLD);
+
+	if(success) {
+		success = region_archive_contains(&ra, x, z, &exists) && exists
+			&& region_archive_read_chunk(&ra, x, z, &data, &length);
+		region_archive_destroy(&ra);
+	}
+
+	region_archive_unlock();
+	string_clear(name);
+
+	if(success) {
+		success = region_archive_decode_blocks(x, z, data, length, sc);
+		free(data);
+	}
+
+	return success;
+}
+
+static void far_terrain_quad(struct displaylist* l, int16_t (*pos)[3],
+							 const uint8_t (*st)[2], uint8_t tex,
+							 uint8_t light) {
+	assert(l && pos && st);
+
+	for(int k = 0; k < 4; k++) {
+		displaylist_pos(l, pos[k][0], pos[k][1], pos[k][2]);
+		displaylist_color(l, light);
+		displaylist_texcoord(l, TEX_OFFSET(TEXTURE_X(tex)) + st[k][0],
+							 TEX_OFFSET(TEXTURE_Y(tex)) + st[k][1]);
+	}
+}
+
+/* one top quad per cell and walls down to lower neighbour cells, or to the
+ * bottom of the world on the column border */
+static size_t far_terrain_cell(struct displaylist* l, struct block_data* top,
+							   struct block_data* above, int k,
+							   const uint8_t* height) {
+	assert(l && top && above && height);
+
+	static const uint8_t st_top[4][2] = {{0, 0}, {16, 0}, {16, 16}, {0, 16}};
+	// in the vertex order of each wall below
+	static const uint8_t st_side[4][4][2] = {
+		{{0, 16}, {0, 0}, {16, 0}, {16, 16}}, // SIDE_LEFT
+		{{16, 16}, {0, 16}, {0, 0}, {16, 0}}, // SIDE_RIGHT
+		{{16, 16}, {0, 16}, {0, 0}, {16, 0}}, // SIDE_FRONT
+		{{0, 16}, {0, 0}, {16, 0}, {16, 16}}, // SIDE_BACK
+	};
+
+	struct block_data neighbours[SIDE_MAX] = {0};
+	neighbours[SIDE_TOP] = *above;
+
+	struct block_info info = (struct block_info) {
+		.block = top,
+		.neighbours = neighbours,
+	};
+
+	int cx = k % FAR_CELLS, cz = k / FAR_CELLS;
+	int16_t x0 = cx * FAR_CELL * FAR_BLK_LEN;
+	int16_t z0 = cz * FAR_CELL * FAR_BLK_LEN;
+	int16_t x1 = x0 + FAR_CELL * FAR_BLK_LEN;
+	int16_t z1 = z0 + FAR_CELL * FAR_BLK_LEN;
+	int16_t y1 = (height[k] - FAR_ORIGIN_Y) * FAR_BLK_LEN;
+
+	far_terrain_quad(l,
+					 (int16_t[4][3]) {{x0, y1, z0},
+									  {x1, y1, z0},
+									  {x1, y1, z1},
+									  {x0, y1, z1}},
+					 st_top,
+					 blocks[top->type]->getTextureIndex(&info, SIDE_TOP), 0x0F);
+	size_t vertices = 4;
+
+	const int offsets[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+	const enum side sides[4] = {SIDE_LEFT, SIDE_RIGHT, SIDE_FRONT, SIDE_BACK};
+
+	for(int s = 0; s < 4; s++) {
+		int nx = cx + offsets[s][0], nz = cz + offsets[s][1];
+		bool inside = nx >= 0 && nx < FAR_CELLS && nz >= 0 && nz < FAR_CELLS;
+		uint8_t floor = inside ? height[nx + nz * FAR_CELLS] : 0;
+
+		if(floor >= height[k])
+			continue;
+
+		int16_t y0 = (floor - FAR_ORIGIN_Y) * FAR_BLK_LEN;
+		uint8_t tex = blocks[top->type]->getTextureIndex(&info, sides[s]);
+		// same shading as full blocks in sky light
+		uint8_t light = (sides[s] == SIDE_LEFT || sides[s] == SIDE_RIGHT) ?
+			0x0D :
+			0x0E;
+		const uint8_t(*st)[2] = st_side[s];
+
+		switch(sides[s]) {
+			case SIDE_LEFT:
+				far_terrain_quad(l,
+								 (int16_t[4][3]) {{x0, y0, z0},
+												  {x0, y1, z0},
+												  {x0, y1, z1},
+												  {x0, y0, z1}},
+								 st, tex, light);
+				break;
+			case SIDE_RIGHT:
+				far_terrain_quad(l,
+								 (int16_t[4][3]) {{x1, y0, z0},
+												  {x1, y0, z1},
+												  {x1, y1, z1},
+												  {x1, y1, z0}},
+								 st, tex, light);
+				break;
+			case SIDE_FRONT:
+				far_terrain_quad(l,
+								 (int16_t[4][3]) {{x0, y0, z0},
+												  {x1, y0, z0},
+												  {x1, y1, z0},
+												  {x0, y1, z0}},
+								 st, tex, light);
+				break;
+			default:
+				far_terrain_quad(l,
+								 (int16_t[4][3]) {{x0, y0, z1},
+												  {x0, y1, z1},
+												  {x1, y1, z1},
+												  {x1, y0, z1}},
+								 st, tex, light);
+				break;
+		}
+
+		vertices += 4;
+	}
+
+	return vertices;
+}
+
+static void far_terrain_build(struct far_terrain_rpc* req,
+							  struct server_chunk* sc) {
+	assert(req && sc);
+
+	uint8_t height[FAR_CELLS * FAR_CELLS];
+	struct block_data top[FAR_CELLS * FAR_CELLS];
+	struct block_data above[FAR_CELLS * FAR_CELLS];
+
+	// highest surface of each cell, keeps the silhouette of hills and trees
+	for(int k = 0; k < FAR_CELLS * FAR_CELLS; k++) {
+		height[k] = 0;
+		top[k] = above[k] = (struct block_data) {.type = BLOCK_AIR};
+
+		for(int j = 0; j < FAR_CELL * FAR_CELL; j++) {
+			int x = (k % FAR_CELLS) * FAR_CELL + j % FAR_CELL;
+			int z = (k / FAR_CELLS) * FAR_CELL + j / FAR_CELL;
+			int h = sc->heightmap[x + z * CHUNK_SIZE];
+
+			if(h <= height[k] || h > WORLD_HEIGHT)
+				continue;
+
+			size_t idx = (h - 1) + (z + x * CHUNK_SIZE) * WORLD_HEIGHT;
+			int shift = (idx % 2) * 4;
+
+			if(!blocks[sc->ids[idx]])
+				continue;
+
+			height[k] = h;
+			top[k] = (struct block_data) {
+				.type = sc->ids[idx],
+				.metadata = (sc->metadata[idx / 2] >> shift) & 0xF,
+			};
+			above[k] = (struct block_data) {
+				.type = (h < WORLD_HEIGHT) ? sc->ids[idx + 1] : BLOCK_AIR,
+			};
+		}
+	}
+
+	size_t vertices[FAR_LIST_MAX] = {0};
+
+	for(int k = 0; k < FAR_LIST_MAX; k++)
+		displaylist_init(req->list + k, 64, 3 * 2 + 2 * 1 + 1);
+
+	for(int k = 0; k < FAR_CELLS * FAR_CELLS; k++) {
+		if(!height[k])
+			continue;
+
+		enum far_list list
+			= (blocks[top[k].type]->renderBlock == render_block_fluid) ?
+			FAR_LIST_FLUID :
+			FAR_LIST_SOLID;
+		vertices[list] += far_terrain_cell(req->list + list, top + k,
+										   above + k, k, height);
+	}
+
+	req->bytes = 0;
+
+	for(int k = 0; k < FAR_LIST_MAX; k++) {
+		req->has_list[k] = vertices[k] > 0;
+
+		if(req->has_list[k]) {
+			displaylist_finalize(req->list + k, vertices[k]);
+			req->bytes += req->list[k].length;
+		} else {
+			displaylist_destroy(req->list + k);
+		}
+	}
+}
+
+static void* far_terrain_thread(void* user) {
+	while(1) {
+		struct far_terrain_rpc* req;
+		tchannel_receive(&far_requests, (void**)&req, true);
+
+		char dir[sizeof(far_world_dir)];
+		tmutex_lock(&far_lock);
+		strcpy(dir, far_world_dir);
+		uint32_t generation = far_generation;
+		tmutex_unlock(&far_lock);
+
+		for(int k = 0; k < FAR_LIST_MAX; k++)
+			req->has_list[k] = false;
+		req->bytes = 0;
+
+		struct server_chunk sc;
+
+		if(req->generation == generation && *dir
+		   && far_terrain_read(dir, req->x, req->z, &sc)) {
+			far_terrain_build(req, &sc);
+
+			free(sc.ids);
+			free(sc.metadata);
+			free(sc.lighting_sky);
+			free(sc.lighting_torch);
+			free(sc.heightmap);
+		}
+
+		tchannel_send(&far_results, req, true);
+	}
+
+	return NULL;
+}
+
+static void far_terrain_free(bool* has_list, struct displaylist* list) {
+	assert(has_list && list);
+
+	for(int k = 0; k < FAR_LIST_MAX; k++) {
+		if(has_list[k])
+			displaylist_destroy(list + k);
+		has_list[k] = false;
+	}
+}
+
+void far_terrain_init() {
+#ifdef PLATFORM_WII
+	far_radius
+		= config_read_int(&gstate.config_user, "far_terrain.distance", 0);
+#else
+	far_radius
+		= config_read_int(&gstate.config_user, "far_terrain.distance", 20);
+#endif
+
+	dict_far_init(far_columns);
+	tmutex_init(&far_lock);
+	far_world_dir[0] = 0;
+	far_generation = 0;
+	far_pending = 0;
+	far_bytes = 0;
+	far_scan_ring = far_radius + 1;
+	far_scan_index = 0;
+
+	if(far_radius <= MAX_VIEW_DISTANCE)
+		far_radius = 0;
+
+	if(!far_radius)
+		return;
+
+	tchannel_init(&far_requests, FAR_QLENGTH);
+	tchannel_init(&far_results, FAR_QLENGTH);
+	tchannel_init(&far_empty_msg, FAR_QLENGTH);
+
+	for(size_t k = 0; k < FAR_QLENGTH; k++)
+		tchannel_send(&far_empty_msg, far_rpc + k, true);
+
+	struct thread t;
+	thread_create(&t, far_terrain_thread, NULL, 4);
+}
+
+static void far_terrain_clear(void) {
+	dict_far_it_t it;
+	dict_far_it(it, far_columns);
+
+	while(!dict_far_end_p(it)) {
+		struct far_column* c = &dict_far_ref(it)->value;
+		far_terrain_free(c->has_list, c->list);
+		dict_far_next(it);
+	}
+
+	dict_far_reset(far_columns);
+	far_bytes = 0;
+}
+
+void far_terrain_set_world(const char* world_dir) {
+	if(!far_radius)
+		return;
+
+	far_terrain_clear();
+
+	tmutex_lock(&far_lock);
+	snprintf(far_world_dir, sizeof(far_world_dir), "%s",
+			 world_dir ? world_dir : "");
+	far_generation++;
+	tmutex_unlock(&far_lock);
+
+	far_scan_ring = FAR_MIN_RING;
+	far_scan_index = 0;
+}
+
+// drops columns that left the far radius, may still have a request in flight
+static void far_terrain_evict(void) {
+	struct stack evict;
+	stack_create(&evict, 16, sizeof(int64_t));
+
+	dict_far_it_t it;
+	dict_far_it(it, far_columns);
+
+	while(!dict_far_end_p(it)) {
+		int64_t id = dict_far_ref(it)->key;
+		w_coord_t x = S_CHUNK_X(id), z = S_CHUNK_Z(id);
+
+		if(abs(x - far_center_x) > far_radius + 1
+		   || abs(z - far_center_z) > far_radius + 1) {
+			struct far_column* c = &dict_far_ref(it)->value;
+			far_bytes -= c->bytes;
+			far_terrain_free(c->has_list, c->list);
+			stack_push(&evict, &id);
+		}
+
+		dict_far_next(it);
+	}
+
+	int64_t id;
+	while(stack_pop(&evict, &id))
+		dict_far_erase(far_columns, id);
+
+	stack_destroy(&evict);
+}
+
+// requests missing columns in rings around the center, nearest first
+static void far_terrain_request(void) {
+	for(; far_scan_ring <= far_radius; far_scan_ring++) {
+		int r = far_scan_ring;
+
+		for(; far_scan_index < r * 8; far_scan_index++) {
+			int side = far_scan_index / (r * 2);
+			int offset = far_scan_index % (r * 2);
+			const int ring[4][2] = {
+				{-r + offset, -r},
+				{r, -r + offset},
+				{r - offset, r},
+				{-r, r - offset},
+			};
+
+			w_coord_t x = far_center_x + ring[side][0];
+			w_coord_t z = far_center_z + ring[side][1];
+
+			if(dict_far_get(far_columns, SECTION_TO_ID(x, z)))
+				continue;
+
+			struct far_terrain_rpc* req;
+			if(!tchannel_receive(&far_empty_msg, (void**)&req, false))
+				return;
+
+			dict_far_set_at(far_columns, SECTION_TO_ID(x, z),
+							(struct far_column) {.pending = true});
+
+			req->x = x;
+			req->z = z;
+			req->generation = far_generation;
+			far_pending++;
+			tchannel_send(&far_requests, req, true);
+		}
+
+		far_scan_index = 0;
+	}
+}
+
+static bool far_terrain_active(struct world* w) {
+	return far_radius > 0 && *far_world_dir
+		&& w->dimension == WORLD_DIM_OVERWORLD;
+}
+
+void far_terrain_update(struct world* w, float x, float z) {
+	assert(w);
+
+	if(!far_radius)
+		return;
+
+	struct far_terrain_rpc* res;
+
+	while(tchannel_receive(&far_results, (void**)&res, false)) {
+		struct far_column* c
+			= dict_far_get(far_columns, SECTION_TO_ID(res->x, res->z));
+		far_pending--;
+
+		if(res->generation == far_generation && c && c->pending) {
+			c->pending = false;
+			c->bytes = res->bytes;
+			far_bytes += res->bytes;
+
+			for(int k = 0; k < FAR_LIST_MAX; k++) {
+				c->has_list[k] = res->has_list[k];
+				c->list[k] = res->list[k];
+			}
+		} else {
+			far_terrain_free(res->has_list, res->list);
+		}
+
+		tchannel_send(&far_empty_msg, res, true);
+	}
+
+	gstate.config.horizon_distance = far_terrain_active(w) ?
+		fmaxf(gstate.config.fog_distance, far_radius * CHUNK_SIZE) :
+		gstate.config.fog_distance;
+
+	if(!far_terrain_active(w))
+		return;
+
+	w_coord_t cx = WCOORD_CHUNK_OFFSET((w_coord_t)floorf(x));
+	w_coord_t cz = WCOORD_CHUNK_OFFSET((w_coord_t)floorf(z));
+
+	if(cx != far_center_x || cz != far_center_z) {
+		far_center_x = cx;
+		far_center_z = cz;
+		far_scan_ring = FAR_MIN_RING;
+		far_scan_index = 0;
+		far_terrain_evict();
+	}
+
+	far_terrain_request();
+}
+
+void far_terrain_render(struct world* w, struct camera* c) {
+	assert(w && c);
+
+	if(!far_terrain_active(w))
+		return;
+
+	float horizon = gstate.config.horizon_distance;
+
+	// chunks are fully fogged at fog_distance, far terrain emerges from there
+	gfx_fog(true);
+	gfx_fog_fade_in(gstate.config.fog_distance);
+	gfx_lighting(true);
+	gfx_blending(MODE_OFF);
+	gfx_alpha_test(false);
+
+	for(int k = 0; k < FAR_LIST_MAX; k++) {
+		gfx_bind_texture((k == FAR_LIST_FLUID) ? &texture_anim :
+												 &texture_terrain);
+
+		dict_far_it_t it;
+		dict_far_it(it, far_columns);
+
+		while(!dict_far_end_p(it)) {
+			int64_t id = dict_far_ref(it)->key;
+			struct far_column* col = &dict_far_ref(it)->value;
+			w_coord_t x = S_CHUNK_X(id) * CHUNK_SIZE;
+			w_coord_t z = S_CHUNK_Z(id) * CHUNK_SIZE;
+			dict_far_next(it);
+
+			if(!col->has_list[k]
+			   || glm_vec2_distance2(
+					  (vec2) {x + CHUNK_SIZE / 2, z + CHUNK_SIZE / 2},
+					  (vec2) {c->x, c->z})
+				   > glm_pow2(horizon * 1.13F)
+			   || world_column_in_view(w, S_CHUNK_X(id), S_CHUNK_Z(id))
+			   || !glm_aabb_frustum(
+				   (vec3[2]) {{x, 0, z},
+							  {x + CHUNK_SIZE, WORLD_HEIGHT, z + CHUNK_SIZE}},
+				   c->frustum_planes))
+				continue;
+
+			mat4 model_view;
+			glm_translate_to(c->view, (vec3) {x, FAR_ORIGIN_Y, z}, model_view);
+			gfx_matrix_modelview(model_view);
+			gfx_fog_pos(x - c->x, z - c->z, horizon);
+			displaylist_render(col->list + k);
+		}
+	}
+
+	gfx_fog_fade_in(0.0F);
+	gfx_alpha_test(true);
+}
+
+void far_terrain_get_stats(struct far_terrain_stats* stats) {
+	assert(stats);
+
+	stats->columns = dict_far_size(far_columns);
+	stats->bytes = far_bytes
+		+ stats->columns * (sizeof(struct far_column) + sizeof(int64_t));
+	stats->pending = far_pending;
+}
@@ -0,0 +1,44 @@
+/*
+	Copyright (c) 2025 Lunna5
+
+	This file is part of CavEX.
+
+	CavEX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	CavEX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with CavEX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FAR_TERRAIN_H
+#define FAR_TERRAIN_H
+
+#include <stddef.h>
+
+struct camera;
+struct world;
+
+struct far_terrain_stats {
+	size_t columns;
+	size_t bytes;
+	size_t pending;
+};
+
+/* Coarse surface meshes of columns beyond the loaded area, read from the
+ * region files of the current world on a background thread. */
+
+void far_terrain_init(void);
+void far_terrain_set_world(const char* world_dir);
+// receives, requests and drops columns, call while no list is rendered
+void far_terrain_update(struct world* w, float x, float z);
+void far_terrain_render(struct world* w, struct camera* c);
+void far_terrain_get_stats(struct far_terrain_stats* stats);
+
+#endif
@@ -185,7 +185,9 @@ void camera_update(struct camera* c, bool in_water) {
 	glm_perspective(glm_rad(gstate.config.fov)
 						* (in_water ? 6.0F / 7.0F : 1.0F),
 					(float)gfx_width() / (float)gfx_height(), 0.075F,
-					gstate.config.render_distance, c->projection);
+					fmaxf(gstate.config.render_distance,
+						  gstate.config.horizon_distance * 1.5F),
+					c->projection);
 
 	glm_lookat((vec3) {c->x, c->y, c->z},
 			   (vec3) {c->x + sinf(c->rx) * sinf(c->ry), c->y + cosf(c->ry),
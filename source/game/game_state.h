@@ -50,6 +50,8 @@ struct game_state {
 		float fov;
 		float render_distance;
 		float fog_distance;
+		// fog of far terrain, beyond fog_distance while far terrain is shown
+		float horizon_distance;
 	} config;
 	struct screen* current_screen;
 	struct camera camera;
@@ -20,6 +20,7 @@
 #include <stddef.h>
 
 #include "../../block/blocks.h"
+#include "../../far_terrain.h"
 #include "../../graphics/gfx_util.h"
 #include "../../graphics/gui_util.h"
 #include "../../graphics/render_model.h"
@@ -322,6 +323,7 @@ static void screen_ingame_update(struct screen* s, float dt) {
 	}
 
 	if(input_pressed(IB_HOME)) {
+		chunk_mesher_set_world(NULL);
 		screen_set(&screen_select_world);
 		svin_rpc_send(&(struct server_rpc) {
 			.type = SRPC_UNLOAD_WORLD,
@@ -333,7 +335,7 @@ static void screen_ingame_update(struct screen* s, float dt) {
 }
 
 static void screen_ingame_render2D(struct screen* s, int width, int height) {
-	char str[64];
+	char str[192];
 	sprintf(str, GAME_NAME " Alpha %i.%i.%i (impl. B1.7.3)", VERSION_MAJOR,
 			VERSION_MINOR, VERSION_PATCH);
 	gutil_text(4, 4 + 17 * 0, str, 16, true);
@@ -344,14 +346,46 @@ static void screen_ingame_render2D(struct screen* s, int width, int height) {
 			gstate.stats.dt_vsync * 1000.0F);
 	gutil_text(4, 4 + 17 * 1, str, 16, true);
 
-	sprintf(str, "%zu chunks", gstate.stats.chunks_rendered);
+	struct world_mesh_stats* ms = &gstate.world.mesh_stats;
+	struct chunk_mesher_stats mesh;
+	chunk_mesher_get_stats(&mesh);
+	sprintf(str,
+			"%zu chunks (%zu lod), %zu meshed (%zu twice, %zu stale, %zu "
+			"merged, %zu empty, %zu cached), %zu waiting",
+			gstate.stats.chunks_rendered, ms->lod, ms->meshed,
+			ms->double_meshed, mesh.superseded, mesh.coalesced, mesh.skipped,
+			mesh.cache_hits, ms->waiting);
 	gutil_text(4, 4 + 17 * 2, str, 16, true);
 
-	sprintf(str, "(%0.1f, %0.1f, %0.1f) (%0.1f, %0.1f)", gstate.camera.x,
-			gstate.camera.y, gstate.camera.z, glm_deg(gstate.camera.rx),
-			glm_deg(gstate.camera.ry));
+	struct pool_stats chunks, storage, snapshots;
+	chunk_get_pool_stats(&chunks, &storage);
+	chunk_mesher_get_pool_stats(&snapshots);
+	sprintf(str,
+			"(%0.1f, %0.1f, %0.1f) (%0.1f, %0.1f), pool misses: %zu/%zu "
+			"chunks, %zu/%zu blocks, %zu/%zu snapshots",
+			gstate.camera.x, gstate.camera.y, gstate.camera.z,
+			glm_deg(gstate.camera.rx), glm_deg(gstate.camera.ry),
+			chunks.misses, chunks.hits + chunks.misses, storage.misses,
+			storage.hits + storage.misses, snapshots.misses,
+			snapshots.hits + snapshots.misses);
 	gutil_text(4, 4 + 17 * 3, str, 16, true);
 
+	struct far_terrain_stats far;
+	far_terrain_get_stats(&far);
+	sprintf(str,
+			"mesh: %zu vertices, %zu KiB (%zu KiB saved), %zu faces merged "
+			"into %zu, far: %zu columns, %zu KiB",
+			mesh.vertices, mesh.bytes / 1024, mesh.saved / 1024,
+			mesh.merged_faces, mesh.merged_quads, far.columns,
+			far.bytes / 1024);
+	gutil_text(4, 4 + 17 * 4, str, 16, true);
+
+	struct world_lighting_stats* ls = &gstate.world.lighting_stats;
+	sprintf(str,
+			"light: %zu pending, %zu updated (%zu merged), %0.1fms latency",
+			ls->pending, ls->updated, ls->coalesced, ls->latency);
+	gutil_text(4, 4 + 17 * 5, str, 16, true);
+
 	if(gstate.camera_hit.hit) {
 		struct block_data bd
 			= world_get_block(&gstate.world, gstate.camera_hit.x,
@@ -361,7 +395,7 @@ static void screen_ingame_render2D(struct screen* s, int width, int height) {
 				block_side_name(gstate.camera_hit.side), gstate.camera_hit.x,
 				gstate.camera_hit.y, gstate.camera_hit.z, b ? b->name : NULL,
 				bd.type, bd.metadata);
-		gutil_text(4, 4 + 17 * 5, str, 16, true);
+		gutil_text(4, 4 + 17 * 6, str, 16, true);
 	}
 #endif
 
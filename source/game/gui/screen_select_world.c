@@ -17,6 +17,8 @@
 	along with CavEX.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include "../../chunk_mesher.h"
+#include "../../far_terrain.h"
 #include "../../graphics/gui_util.h"
 #include "../../network/level_archive.h"
 #include "../../network/server_interface.h"
@@ -212,6 +214,8 @@ static void screen_sworld_update(struct screen* s, float dt) {
 		string_init_set(rpc.payload.load_world.name, opt.path);
 		svin_rpc_send(&rpc);
 
+		chunk_mesher_set_world(string_get_cstr(opt.path));
+		far_terrain_set_world(string_get_cstr(opt.path));
 		screen_set(&screen_load_world);
 	}
 
@@ -1474,6 +1474,86 @@ size_t render_block_full(struct displaylist* d, struct block_info* this,
 	return 1;
 }
 
+#ifdef DISPLAYLIST_TEXCOORD_REPEAT
+static inline void render_block_vertex_repeat(struct displaylist* d, int16_t x,
+											  int16_t y, int16_t z,
+											  uint8_t light, uint8_t tex,
+											  uint16_t s, uint16_t t) {
+	displaylist_pos(d, x, y, z);
+	displaylist_color(d, light);
+	displaylist_texcoord_repeat(d, TEXTURE_X(tex), TEXTURE_Y(tex), s, t);
+}
+
+size_t render_block_full_merged(struct displaylist* d, int x, int y, int z,
+								int width, int height, enum side side,
+								uint8_t tex, uint8_t luminance, uint8_t light,
+								bool count_only) {
+	assert(width > 0 && height > 0 && width <= 16 && height <= 16);
+
+	if(count_only)
+		return 1;
+
+	int16_t px = x * BLK_LEN, py = y * BLK_LEN, pz = z * BLK_LEN;
+	int16_t w = width * BLK_LEN, h = height * BLK_LEN;
+	uint16_t ts = width * 16, tt = height * 16;
+
+	switch(side) {
+		case SIDE_LEFT: // x minus
+			light = DIM_LIGHT(light, level_table_1, true, luminance);
+			render_block_vertex_repeat(d, px, py, pz, light, tex, 0, tt);
+			render_block_vertex_repeat(d, px, py + h, pz, light, tex, 0, 0);
+			render_block_vertex_repeat(d, px, py + h, pz + w, light, tex, ts,
+									   0);
+			render_block_vertex_repeat(d, px, py, pz + w, light, tex, ts, tt);
+			break;
+		case SIDE_RIGHT: // x positive
+			px += BLK_LEN;
+			light = DIM_LIGHT(light, level_table_1, true, luminance);
+			render_block_vertex_repeat(d, px, py, pz, light, tex, ts, tt);
+			render_block_vertex_repeat(d, px, py, pz + w, light, tex, 0, tt);
+			render_block_vertex_repeat(d, px, py + h, pz + w, light, tex, 0, 0);
+			render_block_vertex_repeat(d, px, py + h, pz, light, tex, ts, 0);
+			break;
+		case SIDE_TOP: // y positive
+			py += BLK_LEN;
+			light = DIM_LIGHT(light, NULL, false, luminance);
+			render_block_vertex_repeat(d, px, py, pz, light, tex, 0, 0);
+			render_block_vertex_repeat(d, px + w, py, pz, light, tex, ts, 0);
+			render_block_vertex_repeat(d, px + w, py, pz + h, light, tex, ts,
+									   tt);
+			render_block_vertex_repeat(d, px, py, pz + h, light, tex, 0, tt);
+			break;
+		case SIDE_BOTTOM: // y negative
+			light = DIM_LIGHT(light, level_table_0, true, luminance);
+			render_block_vertex_repeat(d, px, py, pz, light, tex, 0, tt);
+			render_block_vertex_repeat(d, px, py, pz + h, light, tex, 0, 0);
+			render_block_vertex_repeat(d, px + w, py, pz + h, light, tex, ts,
+									   0);
+			render_block_vertex_repeat(d, px + w, py, pz, light, tex, ts, tt);
+			break;
+		case SIDE_FRONT: // z minus
+			light = DIM_LIGHT(light, level_table_2, true, luminance);
+			render_block_vertex_repeat(d, px, py, pz, light, tex, ts, tt);
+			render_block_vertex_repeat(d, px + w, py, pz, light, tex, 0, tt);
+			render_block_vertex_repeat(d, px + w, py + h, pz, light, tex, 0, 0);
+			render_block_vertex_repeat(d, px, py + h, pz, light, tex, ts, 0);
+			break;
+		case SIDE_BACK: // z positive
+			pz += BLK_LEN;
+			light = DIM_LIGHT(light, level_table_2, true, luminance);
+			render_block_vertex_repeat(d, px, py, pz, light, tex, 0, tt);
+			render_block_vertex_repeat(d, px, py + h, pz, light, tex, 0, 0);
+			render_block_vertex_repeat(d, px + w, py + h, pz, light, tex, ts,
+									   0);
+			render_block_vertex_repeat(d, px + w, py, pz, light, tex, ts, tt);
+			break;
+		default: break;
+	}
+
+	return 1;
+}
+#endif
+
 static struct displaylist block_cracks_dl;
 static uint8_t block_cracks_light[24];
 
@@ -73,6 +73,13 @@ size_t render_block_full(struct displaylist* d, struct block_info* this,
 						 enum side side, struct block_info* it,
 						 uint8_t* vertex_light, bool count_only);
 
+#ifdef DISPLAYLIST_TEXCOORD_REPEAT
+size_t render_block_full_merged(struct displaylist* d, int x, int y, int z,
+								int width, int height, enum side side,
+								uint8_t tex, uint8_t luminance, uint8_t light,
+								bool count_only);
+#endif
+
 size_t render_block_slab(struct displaylist* d, struct block_info* this,
 						 enum side side, struct block_info* it,
 						 uint8_t* vertex_light, bool count_only);
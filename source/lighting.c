@@ -18,6 +18,7 @@
 */
 
 #include <assert.h>
+#include <stdlib.h>
 
 #include "lighting.h"
 
@@ -51,29 +52,60 @@ void lighting_heightmap_update(uint8_t* heightmap, c_coord_t x, w_coord_t y,
 
 struct lighting_update_entry {
 	w_coord_t x, y, z;
+	// set and spread light even if it did not change
+	bool source;
 };
 
 static inline int8_t MAX_I8(int8_t a, int8_t b) {
 	return a > b ? a : b;
 }
 
-void lighting_update_at_block(
-	struct world_modification_entry source, bool ignore_sky_light,
+static int lighting_compare_source(const void* a, const void* b) {
+	const struct world_modification_entry* sa = a;
+	const struct world_modification_entry* sb = b;
+
+	if(sa->x != sb->x)
+		return (sa->x > sb->x) - (sa->x < sb->x);
+
+	if(sa->y != sb->y)
+		return (sa->y > sb->y) - (sa->y < sb->y);
+
+	return (sa->z > sb->z) - (sa->z < sb->z);
+}
+
+size_t lighting_update_at_blocks(
+	struct world_modification_entry* sources, size_t count,
+	bool ignore_sky_light,
 	bool (*get_block)(void* user, w_coord_t x, w_coord_t y, w_coord_t z,
 					  struct block_data* blk, uint8_t* height),
 	void (*set_light)(void* user, w_coord_t x, w_coord_t y, w_coord_t z,
 					  uint8_t light),
 	void* user) {
-	assert(get_block && set_light);
+	assert(sources && get_block && set_light);
+
+	if(!count)
+		return 0;
+
+	// updates to the same block are merged
+	qsort(sources, count, sizeof(*sources), lighting_compare_source);
+
+	size_t unique = 1;
+	for(size_t k = 1; k < count; k++) {
+		if(lighting_compare_source(sources + unique - 1, sources + k))
+			sources[unique++] = sources[k];
+	}
 
 	struct stack queue;
 	stack_create(&queue, 128, sizeof(struct lighting_update_entry));
-	stack_push(&queue,
-			   &(struct lighting_update_entry) {
-				   .x = source.x,
-				   .y = source.y,
-				   .z = source.z,
-			   });
+
+	for(size_t k = 0; k < unique; k++)
+		stack_push(&queue,
+				   &(struct lighting_update_entry) {
+					   .x = sources[k].x,
+					   .y = sources[k].y,
+					   .z = sources[k].z,
+					   .source = true,
+				   });
 
 	while(!stack_empty(&queue)) {
 		struct lighting_update_entry current;
@@ -121,9 +153,7 @@ void lighting_update_at_block(
 
 		uint8_t new_light = (new_light_torch << 4) | new_light_sky;
 
-		if(old_light != new_light
-		   || (source.x == current.x && source.y == current.y
-			   && source.z == current.z)) {
+		if(old_light != new_light || current.source) {
 			set_light(user, current.x, current.y, current.z, new_light);
 
 			for(enum side s = 0; s < SIDE_MAX; s++) {
@@ -137,10 +167,23 @@ void lighting_update_at_block(
 								   .x = current.x + x,
 								   .y = current.y + y,
 								   .z = current.z + z,
+								   .source = false,
 							   });
 			}
 		}
 	}
 
 	stack_destroy(&queue);
+	return unique;
+}
+
+void lighting_update_at_block(
+	struct world_modification_entry source, bool ignore_sky_light,
+	bool (*get_block)(void* user, w_coord_t x, w_coord_t y, w_coord_t z,
+					  struct block_data* blk, uint8_t* height),
+	void (*set_light)(void* user, w_coord_t x, w_coord_t y, w_coord_t z,
+					  uint8_t light),
+	void* user) {
+	lighting_update_at_blocks(&source, 1, ignore_sky_light, get_block,
+							  set_light, user);
 }
@@ -34,6 +34,17 @@ void lighting_heightmap_update(uint8_t* heightmap, c_coord_t x, w_coord_t y,
 												 struct block_data* blk),
 							   void* user);
 
+/* one flood from all sources, which are sorted and merged in place, returns
+ * the number of different positions */
+size_t lighting_update_at_blocks(
+	struct world_modification_entry* sources, size_t count,
+	bool ignore_sky_light,
+	bool (*get_block)(void* user, w_coord_t x, w_coord_t y, w_coord_t z,
+					  struct block_data* blk, uint8_t* height),
+	void (*set_light)(void* user, w_coord_t x, w_coord_t y, w_coord_t z,
+					  uint8_t light),
+	void* user);
+
 void lighting_update_at_block(
 	struct world_modification_entry source, bool ignore_sky_light,
 	bool (*get_block)(void* user, w_coord_t x, w_coord_t y, w_coord_t z,
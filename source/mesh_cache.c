@@ -0,0 +1,193 @@
+/*
+	Copyright (c) 2025 Lunna5
+
+	This file is part of CavEX.
+
+	CavEX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	CavEX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with CavEX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "mesh_cache.h"
+#include "world.h"
+
+#define MESH_CACHE_MAGIC 0x4D455348
+#define MESH_CACHE_VOLUME                                                      \
+	((CHUNK_SIZE + 2) * (CHUNK_SIZE + 2) * (CHUNK_SIZE + 2))
+
+#ifdef PLATFORM_WII
+#define MESH_CACHE_PLATFORM 2
+#else
+#define MESH_CACHE_PLATFORM 1
+#endif
+
+// written in native byte order, the platform tag keeps files apart
+struct mesh_cache_header {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t platform;
+	uint64_t hash;
+	uint32_t length;
+	uint32_t vertices[13];
+	uint32_t stats[3];
+	uint8_t has_displist[13];
+	uint8_t reachable[6];
+};
+
+uint64_t mesh_cache_hash(const struct block_data* blocks) {
+	assert(blocks);
+
+	uint64_t h = 0x9E3779B97F4A7C15ULL ^ CHUNK_MESHER_VERSION;
+
+	for(size_t k = 0; k < MESH_CACHE_VOLUME; k++) {
+		uint32_t v = blocks[k].type | blocks[k].metadata << 8
+			| blocks[k].sky_light << 12 | blocks[k].torch_light << 16;
+		h = (h ^ v) * 0xFF51AFD7ED558CCDULL;
+		h ^= h >> 32;
+	}
+
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+static void mesh_cache_path(char* path, size_t length, const char* dir,
+							w_coord_t x, w_coord_t y, w_coord_t z, bool lod) {
+	snprintf(path, length, "%s/%i.%i.%i%s.bin", dir, (int)(x / CHUNK_SIZE),
+			 (int)(y / CHUNK_SIZE), (int)(z / CHUNK_SIZE), lod ? ".lod" : "");
+}
+
+bool mesh_cache_read(const char* dir, w_coord_t x, w_coord_t y, w_coord_t z,
+					 bool lod, uint64_t hash, struct chunk_mesher_result* res) {
+	assert(dir && res);
+
+	char path[512];
+	mesh_cache_path(path, sizeof(path), dir, x, y, z, lod);
+
+	FILE* f = fopen(path, "rb");
+
+	if(!f)
+		return false;
+
+	struct mesh_cache_header h;
+
+	if(fread(&h, sizeof(h), 1, f) != 1 || h.magic != MESH_CACHE_MAGIC
+	   || h.version != CHUNK_MESHER_VERSION
+	   || h.platform != MESH_CACHE_PLATFORM || h.hash != hash) {
+		fclose(f);
+		return false;
+	}
+
+	res->has_mesh = false;
+
+	for(int k = 0; k < 13; k++) {
+		res->has_displist[k] = h.has_displist[k];
+		res->has_mesh = res->has_mesh || h.has_displist[k];
+	}
+
+	if(res->has_mesh) {
+		size_t vertices[13];
+		for(int k = 0; k < 13; k++)
+			vertices[k] = h.vertices[k];
+
+		displaylist_batch_init(&res->mesh, 13, vertices,
+							   CHUNK_MESHER_VERTEX_SIZE);
+
+		if(res->mesh.length != h.length
+		   || fread(res->mesh.data, h.length, 1, f) != 1) {
+			displaylist_batch_destroy(&res->mesh);
+			fclose(f);
+			return false;
+		}
+
+		displaylist_batch_finalize_raw(&res->mesh);
+	}
+
+	fclose(f);
+
+	for(int k = 0; k < 6; k++)
+		res->reachable[k] = h.reachable[k];
+
+	res->stats = (struct chunk_mesher_stats) {
+		.vertices = h.stats[0],
+		.bytes = h.length,
+		.saved = res->has_mesh ? displaylist_batch_saved(&res->mesh) : 0,
+		.merged_faces = h.stats[1],
+		.merged_quads = h.stats[2],
+	};
+
+	return true;
+}
+
+void mesh_cache_write(const char* dir, w_coord_t x, w_coord_t y, w_coord_t z,
+					  bool lod, uint64_t hash,
+					  struct chunk_mesher_result* res) {
+	assert(dir && res);
+
+	struct mesh_cache_header h;
+	memset(&h, 0, sizeof(h));
+	h.magic = MESH_CACHE_MAGIC;
+	h.version = CHUNK_MESHER_VERSION;
+	h.platform = MESH_CACHE_PLATFORM;
+	h.hash = hash;
+
+	if(res->has_mesh) {
+		h.length = res->mesh.length;
+
+		for(int k = 0; k < 13; k++)
+			h.vertices[k] = res->mesh.vertices[k];
+	}
+
+	h.stats[0] = res->stats.vertices;
+	h.stats[1] = res->stats.merged_faces;
+	h.stats[2] = res->stats.merged_quads;
+
+	for(int k = 0; k < 13; k++)
+		h.has_displist[k] = res->has_displist[k];
+
+	for(int k = 0; k < 6; k++)
+		h.reachable[k] = res->reachable[k];
+
+	char path[512];
+	mesh_cache_path(path, sizeof(path), dir, x, y, z, lod);
+
+	// unique per snapshot, so that a concurrent reader never sees half a file
+	char tmp[sizeof(path) + 18];
+
+	if(snprintf(tmp, sizeof(tmp), "%s.%016llx", path, (unsigned long long)hash)
+	   >= (int)sizeof(tmp))
+		return;
+
+	FILE* f = fopen(tmp, "wb");
+
+	if(!f)
+		return;
+
+	bool ok = fwrite(&h, sizeof(h), 1, f) == 1
+		&& (!h.length || fwrite(res->mesh.data, h.length, 1, f) == 1);
+
+	if(fclose(f) != 0 || !ok) {
+		remove(tmp);
+		return;
+	}
+
+	// rename() does not replace existing files everywhere
+	remove(path);
+
+	if(rename(tmp, path) != 0)
+		remove(tmp);
+}
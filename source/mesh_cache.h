@@ -0,0 +1,41 @@
+/*
+	Copyright (c) 2025 Lunna5
+
+	This file is part of CavEX.
+
+	CavEX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	CavEX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with CavEX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "block/blocks_data.h"
+#include "chunk_mesher.h"
+
+/* Meshes are stored per chunk position and detail level under a directory,
+ * each file is only valid for the snapshot hash, mesher version and platform
+ * it was written with. */
+
+// hash of an 18^3 chunk snapshot, includes everything the mesher reads
+uint64_t mesh_cache_hash(const struct block_data* blocks);
+bool mesh_cache_read(const char* dir, w_coord_t x, w_coord_t y, w_coord_t z,
+					 bool lod, uint64_t hash, struct chunk_mesher_result* res);
+void mesh_cache_write(const char* dir, w_coord_t x, w_coord_t y, w_coord_t z,
+					  bool lod, uint64_t hash,
+					  struct chunk_mesher_result* res);
+
+#endif
@@ -47,36 +47,44 @@ void clin_chunk(w_coord_t x, w_coord_t y, w_coord_t z, w_coord_t sx,
 	assert(sx > 0 && sz > 0 && y >= 0 && y + sy <= WORLD_HEIGHT);
 	assert(ids && metadata && lighting_sky && lighting_torch);
 
-	uint8_t* ids_t = ids;
-	uint8_t* metadata_t = metadata;
-	uint8_t* lighting_s_t = lighting_sky;
-	uint8_t* lighting_t_t = lighting_torch;
-	bool flip = true;
-
-	for(w_coord_t ox = x; ox < x + sx; ox++) {
-		for(w_coord_t oz = z; oz < z + sz; oz++) {
-			for(w_coord_t oy = y; oy < y + sy; oy++) {
-				uint8_t md = flip ? (*metadata_t) & 0xF : (*metadata_t) >> 4;
-				uint8_t sky
-					= flip ? (*lighting_s_t) & 0xF : (*lighting_s_t) >> 4;
-				uint8_t torch
-					= flip ? (*lighting_t_t) & 0xF : (*lighting_t_t) >> 4;
-
-				world_set_block(&gstate.world, ox, oy, oz,
-								(struct block_data) {
-									.type = *ids_t,
-									.metadata = md,
-									.sky_light = sky,
-									.torch_light = torch,
-								},
-								false);
-				ids_t++;
-
-				flip = !flip;
-				if(flip) {
-					lighting_s_t++;
-					lighting_t_t++;
-					metadata_t++;
+	if(sx == CHUNK_SIZE && sz == CHUNK_SIZE && y == 0 && sy == WORLD_HEIGHT
+	   && W2C_COORD(x) == 0 && W2C_COORD(z) == 0) {
+		world_load_column(&gstate.world, WCOORD_CHUNK_OFFSET(x),
+						  WCOORD_CHUNK_OFFSET(z), ids, metadata, lighting_sky,
+						  lighting_torch);
+	} else {
+		uint8_t* ids_t = ids;
+		uint8_t* metadata_t = metadata;
+		uint8_t* lighting_s_t = lighting_sky;
+		uint8_t* lighting_t_t = lighting_torch;
+		bool flip = true;
+
+		for(w_coord_t ox = x; ox < x + sx; ox++) {
+			for(w_coord_t oz = z; oz < z + sz; oz++) {
+				for(w_coord_t oy = y; oy < y + sy; oy++) {
+					uint8_t md
+						= flip ? (*metadata_t) & 0xF : (*metadata_t) >> 4;
+					uint8_t sky
+						= flip ? (*lighting_s_t) & 0xF : (*lighting_s_t) >> 4;
+					uint8_t torch
+						= flip ? (*lighting_t_t) & 0xF : (*lighting_t_t) >> 4;
+
+					world_set_block(&gstate.world, ox, oy, oz,
+									(struct block_data) {
+										.type = *ids_t,
+										.metadata = md,
+										.sky_light = sky,
+										.torch_light = torch,
+									},
+									false);
+					ids_t++;
+
+					flip = !flip;
+					if(flip) {
+						lighting_s_t++;
+						lighting_t_t++;
+						metadata_t++;
+					}
 				}
 			}
 		}
@@ -21,12 +21,27 @@
 #include <m-lib/m-string.h>
 
 #include "../cNBT/nbt.h"
+#include "../platform/thread.h"
 
 #include "region_archive.h"
 #include "server_world.h"
 
 #define CHUNK_EXISTS(offset, sectors) ((offset) >= 2 && (sectors) >= 1)
 
+static struct thread_mutex region_file_lock;
+
+void region_archive_init(void) {
+	tmutex_init(&region_file_lock);
+}
+
+void region_archive_lock(void) {
+	tmutex_lock(&region_file_lock);
+}
+
+void region_archive_unlock(void) {
+	tmutex_unlock(&region_file_lock);
+}
+
 static uint32_t conv_u32_native(uint8_t* data) {
 	return (data[0] << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
 }
@@ -100,9 +115,11 @@ bool region_archive_create_new(struct region_archive* ra, string_t world_name,
 						   string_get_cstr(world_name), x, z);
 	}
 
+	region_archive_lock();
 	FILE* f = fopen(string_get_cstr(ra->file_name), "w");
 
 	if(!f) {
+		region_archive_unlock();
 		string_clear(ra->file_name);
 		return false;
 	}
@@ -111,6 +128,7 @@ bool region_archive_create_new(struct region_archive* ra, string_t world_name,
 		fwrite((uint32_t[]) {0}, sizeof(uint32_t), 1, f);
 
 	fclose(f);
+	region_archive_unlock();
 	string_clear(ra->file_name);
 
 	return region_archive_create(ra, world_name, x, z, dimension);
@@ -205,9 +223,9 @@ bool region_archive_contains(struct region_archive* ra, w_coord_t x,
 	return true;
 }
 
-bool region_archive_get_blocks(struct region_archive* ra, w_coord_t x,
-							   w_coord_t z, struct server_chunk* sc) {
-	assert(ra && sc);
+bool region_archive_read_chunk(struct region_archive* ra, w_coord_t x,
+							   w_coord_t z, void** data, size_t* length) {
+	assert(ra && data && length);
 	bool chunk_exists;
 	assert(region_archive_contains(ra, x, z, &chunk_exists) && chunk_exists);
 
@@ -229,9 +247,9 @@ bool region_archive_get_blocks(struct region_archive* ra, w_coord_t x,
 		return false;
 	}
 
-	uint32_t length;
-	if(!fread_u32(&length, f)
-	   || length + sizeof(uint32_t) > sectors * REGION_SECTOR_SIZE) {
+	uint32_t stored;
+	if(!fread_u32(&stored, f) || stored < 2
+	   || stored + sizeof(uint32_t) > sectors * REGION_SECTOR_SIZE) {
 		fclose(f);
 		return false;
 	}
@@ -242,23 +260,29 @@ bool region_archive_get_blocks(struct region_archive* ra, w_coord_t x,
 		return false;
 	}
 
-	void* nbt_compressed = malloc(length - 1);
+	*length = stored - 1;
+	*data = malloc(*length);
 
-	if(!nbt_compressed) {
+	if(!*data) {
 		fclose(f);
 		return false;
 	}
 
-	if(!fread(nbt_compressed, length - 1, 1, f)) {
-		free(nbt_compressed);
+	if(!fread(*data, *length, 1, f)) {
+		free(*data);
 		fclose(f);
 		return false;
 	}
 
-	nbt_node* chunk = nbt_parse_compressed(nbt_compressed, length - 1);
-
-	free(nbt_compressed);
 	fclose(f);
+	return true;
+}
+
+bool region_archive_decode_blocks(w_coord_t x, w_coord_t z, void* data,
+								  size_t length, struct server_chunk* sc) {
+	assert(data && sc);
+
+	nbt_node* chunk = nbt_parse_compressed(data, length);
 
 	if(!chunk)
 		return false;
@@ -314,6 +338,21 @@ bool region_archive_get_blocks(struct region_archive* ra, w_coord_t x,
 	return true;
 }
 
+bool region_archive_get_blocks(struct region_archive* ra, w_coord_t x,
+							   w_coord_t z, struct server_chunk* sc) {
+	assert(ra && sc);
+
+	void* data;
+	size_t length;
+
+	if(!region_archive_read_chunk(ra, x, z, &data, &length))
+		return false;
+
+	bool success = region_archive_decode_blocks(x, z, data, length, sc);
+	free(data);
+	return success;
+}
+
 static bool file_overwrite_index(FILE* f, size_t index, uint32_t data) {
 	assert(f);
 
@@ -369,8 +408,9 @@ static bool file_overwrite_chunk(FILE* f, size_t offset, void* data,
 	return true;
 }
 
-bool region_archive_set_blocks(struct region_archive* ra, w_coord_t x,
-							   w_coord_t z, struct server_chunk* sc) {
+static bool region_archive_write_blocks(struct region_archive* ra,
+									   w_coord_t x, w_coord_t z,
+									   struct server_chunk* sc) {
 	assert(ra && sc);
 	assert(CHUNK_REGION_COORD(x) == ra->x && CHUNK_REGION_COORD(z) == ra->z);
 
@@ -554,3 +594,14 @@ bool region_archive_set_blocks(struct region_archive* ra, w_coord_t x,
 	buffer_free(&res);
 	return success;
 }
+
+bool region_archive_set_blocks(struct region_archive* ra, w_coord_t x,
+							   w_coord_t z, struct server_chunk* sc) {
+	assert(ra && sc);
+
+	region_archive_lock();
+	bool success = region_archive_write_blocks(ra, x, z, sc);
+	region_archive_unlock();
+
+	return success;
+}
@@ -46,6 +46,11 @@ ILIST_DEF(ilist_regions, struct region_archive, M_POD_OPLIST)
 
 #define CHUNK_REGION_COORD(x) ((w_coord_t)floor(x / (float)REGION_SIZE))
 
+void region_archive_init(void);
+// held while a region file is written, readers on other threads take it too
+void region_archive_lock(void);
+void region_archive_unlock(void);
+
 bool region_archive_create_new(struct region_archive* ra, string_t world_name,
 							   w_coord_t x, w_coord_t z,
 							   world_dim dimension);
@@ -56,6 +61,11 @@ bool region_archive_contains(struct region_archive* ra, w_coord_t x,
 							 w_coord_t z, bool* chunk_exists);
 bool region_archive_get_blocks(struct region_archive* ra, w_coord_t x,
 							   w_coord_t z, struct server_chunk* sc);
+// the compressed nbt of a chunk, to be freed by the caller
+bool region_archive_read_chunk(struct region_archive* ra, w_coord_t x,
+							   w_coord_t z, void** data, size_t* length);
+bool region_archive_decode_blocks(w_coord_t x, w_coord_t z, void* data,
+								  size_t length, struct server_chunk* sc);
 bool region_archive_set_blocks(struct region_archive* ra, w_coord_t x,
 							   w_coord_t z, struct server_chunk* sc);
 
@@ -154,6 +154,49 @@ bool server_world_get_block(struct server_world* w, w_coord_t x, w_coord_t y,
 	return true;
 }
 
+static void server_world_volume_fetch(void* chunk, w_coord_t x, w_coord_t y,
+									  w_coord_t z, struct block_data* blk) {
+	struct server_chunk* sc = chunk;
+
+	if(sc && y >= 0 && y < WORLD_HEIGHT) {
+		size_t idx = S_CHUNK_IDX(W2C_COORD(x), y, W2C_COORD(z));
+
+		*blk = (struct block_data) {
+			.type = sc->ids[idx],
+			.metadata = nibble_read(sc->metadata, idx),
+			.sky_light = nibble_read(sc->lighting_sky, idx),
+			.torch_light = nibble_read(sc->lighting_torch, idx),
+		};
+	} else {
+		*blk = (struct block_data) {
+			.type = BLOCK_AIR,
+			.metadata = 0,
+			.sky_light = 0,
+			.torch_light = 0,
+		};
+	}
+}
+
+void server_world_resolve_volume(struct server_world* w,
+								 struct block_volume* v) {
+	assert(w && v);
+
+	size_t layer = v->chunk_width * v->chunk_depth;
+
+	for(w_coord_t z = 0; z < v->chunk_depth; z++) {
+		for(w_coord_t x = 0; x < v->chunk_width; x++) {
+			struct server_chunk* sc = dict_server_chunks_get(
+				w->chunks, S_CHUNK_ID(v->chunk_x + x, v->chunk_z + z));
+
+			// a column covers all chunk layers
+			for(w_coord_t y = 0; y < v->chunk_height; y++)
+				v->chunks[x + z * v->chunk_width + y * layer] = sc;
+		}
+	}
+
+	v->fetch = server_world_volume_fetch;
+}
+
 bool server_world_set_block(struct server_world* w, w_coord_t x, w_coord_t y,
 							w_coord_t z, struct block_data blk) {
 	assert(w);
@@ -24,6 +24,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "../block_volume.h"
 #include "region_archive.h"
 
 struct server_chunk {
@@ -59,6 +60,9 @@ void server_world_destroy(struct server_world* w);
 
 bool server_world_get_block(struct server_world* w, w_coord_t x, w_coord_t y,
 							w_coord_t z, struct block_data* blk);
+// blocks outside of loaded chunks are air
+void server_world_resolve_volume(struct server_world* w,
+								 struct block_volume* v);
 bool server_world_set_block(struct server_world* w, w_coord_t x, w_coord_t y,
 							w_coord_t z, struct block_data blk);
 
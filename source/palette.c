@@ -0,0 +1,245 @@
+/*
+	Copyright (c) 2025 Lunna5
+
+	This file is part of CavEX.
+
+	CavEX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	CavEX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with CavEX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <string.h>
+
+#include "palette.h"
+#include "pool.h"
+
+// indexed by log2 of bits, the indices are followed by the entries
+static struct pool palette_pools[5];
+
+static size_t palette_pool_index(uint8_t bits) {
+	size_t index = 0;
+	while((1U << index) < bits)
+		index++;
+	return index;
+}
+
+#define PALETTE_POOL(bits) (palette_pools + palette_pool_index(bits))
+
+static size_t palette_buffer_size(uint8_t bits) {
+	return (bits == 16) ?
+		PALETTE_LENGTH * sizeof(uint16_t) :
+		PALETTE_LENGTH * bits / 8 + (1 << bits) * sizeof(uint16_t);
+}
+
+void palette_pool_init(void) {
+	for(size_t k = 0; k < 5; k++)
+		pool_create(palette_pools + k, palette_buffer_size(1 << k), 0);
+}
+
+void palette_get_pool_stats(struct pool_stats* stats) {
+	assert(stats);
+	*stats = (struct pool_stats) {0};
+
+	for(size_t k = 0; k < 5; k++) {
+		struct pool_stats s;
+		pool_get_stats(palette_pools + k, &s);
+		stats->hits += s.hits;
+		stats->misses += s.misses;
+		stats->in_use += s.in_use;
+		stats->capacity += s.capacity;
+	}
+}
+
+void palette_init(struct palette* p, uint16_t value) {
+	assert(p);
+
+	p->entries = NULL;
+	p->data = NULL;
+	p->uniform = value;
+	p->length = 1;
+	p->bits = 0;
+}
+
+void palette_destroy(struct palette* p) {
+	assert(p);
+
+	if(p->data)
+		pool_free(PALETTE_POOL(p->bits), p->data);
+}
+
+void palette_copy(struct palette* dst, struct palette* src) {
+	assert(dst && src);
+
+	*dst = *src;
+
+	if(src->data) {
+		dst->data = pool_alloc(PALETTE_POOL(src->bits));
+		memcpy(dst->data, src->data, palette_buffer_size(src->bits));
+
+		if(src->entries)
+			dst->entries
+				= (uint16_t*)(dst->data + PALETTE_LENGTH * dst->bits / 8);
+	}
+}
+
+static inline size_t palette_index(struct palette* p, size_t index) {
+	size_t bit = index * p->bits;
+	return (p->data[bit / 8] >> (bit % 8)) & ((1 << p->bits) - 1);
+}
+
+uint16_t palette_get(struct palette* p, size_t index) {
+	assert(p && index < PALETTE_LENGTH);
+
+	switch(p->bits) {
+		case 0: return p->uniform;
+		case 16: return ((uint16_t*)p->data)[index];
+		default: return p->entries[palette_index(p, index)];
+	}
+}
+
+void palette_get_range(struct palette* p, size_t index, size_t count,
+					   uint16_t* out) {
+	assert(p && index + count <= PALETTE_LENGTH && out);
+
+	switch(p->bits) {
+		case 0:
+			for(size_t k = 0; k < count; k++)
+				out[k] = p->uniform;
+			break;
+		case 16:
+			memcpy(out, (uint16_t*)p->data + index, count * sizeof(uint16_t));
+			break;
+		case 8:
+			for(size_t k = 0; k < count; k++)
+				out[k] = p->entries[p->data[index + k]];
+			break;
+		default:
+			for(size_t k = 0; k < count; k++)
+				out[k] = p->entries[palette_index(p, index + k)];
+			break;
+	}
+}
+
+static void palette_write_index(struct palette* p, size_t index,
+								size_t entry) {
+	size_t bit = index * p->bits;
+	uint8_t mask = ((1 << p->bits) - 1) << (bit % 8);
+	p->data[bit / 8] = (p->data[bit / 8] & ~mask) | (entry << (bit % 8));
+}
+
+// picks the smallest representation for values
+void palette_fill(struct palette* p, const uint16_t* values) {
+	assert(p && values);
+
+	uint16_t entries[PALETTE_MAX_ENTRIES];
+	// kept off the stack, threads on Wii only get a small one
+	uint8_t* indices = pool_alloc(PALETTE_POOL(8));
+	size_t length = 0, last = 0;
+	bool plain = false;
+
+	for(size_t k = 0; k < PALETTE_LENGTH && !plain; k++) {
+		// values mostly come in runs
+		if(length > 0 && entries[last] == values[k]) {
+			indices[k] = last;
+			continue;
+		}
+
+		last = 0;
+		while(last < length && entries[last] != values[k])
+			last++;
+
+		if(last == length) {
+			if(length == PALETTE_MAX_ENTRIES) {
+				plain = true;
+				break;
+			}
+
+			entries[length++] = values[k];
+		}
+
+		indices[k] = last;
+	}
+
+	palette_destroy(p);
+	p->entries = NULL;
+	p->data = NULL;
+
+	if(plain) {
+		p->bits = 16;
+		p->length = 0;
+		p->data = pool_alloc(PALETTE_POOL(p->bits));
+		memcpy(p->data, values, PALETTE_LENGTH * sizeof(uint16_t));
+		pool_free(PALETTE_POOL(8), indices);
+		return;
+	}
+
+	p->length = length;
+
+	if(length == 1) {
+		p->bits = 0;
+		p->uniform = entries[0];
+		pool_free(PALETTE_POOL(8), indices);
+		return;
+	}
+
+	p->bits = 1;
+	while((1U << p->bits) < length)
+		p->bits *= 2;
+
+	p->data = pool_alloc(PALETTE_POOL(p->bits));
+	p->entries = (uint16_t*)(p->data + PALETTE_LENGTH * p->bits / 8);
+	memset(p->data, 0, PALETTE_LENGTH * p->bits / 8);
+	memcpy(p->entries, entries, length * sizeof(uint16_t));
+
+	for(size_t k = 0; k < PALETTE_LENGTH; k++)
+		palette_write_index(p, k, indices[k]);
+
+	pool_free(PALETTE_POOL(8), indices);
+}
+
+void palette_set(struct palette* p, size_t index, uint16_t value) {
+	assert(p && index < PALETTE_LENGTH);
+
+	if(p->bits == 16) {
+		((uint16_t*)p->data)[index] = value;
+		return;
+	}
+
+	if(p->bits == 0 && p->uniform == value)
+		return;
+
+	size_t entry = 0;
+	while(entry < p->length && p->entries && p->entries[entry] != value)
+		entry++;
+
+	if(p->bits > 0 && entry == p->length && entry < (1U << p->bits))
+		p->entries[p->length++] = value;
+
+	if(p->bits > 0 && entry < p->length) {
+		palette_write_index(p, index, entry);
+		return;
+	}
+
+	// out of entries, also drops entries that are no longer used
+	uint16_t* values = pool_alloc(PALETTE_POOL(16));
+	palette_get_range(p, 0, PALETTE_LENGTH, values);
+	values[index] = value;
+	palette_fill(p, values);
+	pool_free(PALETTE_POOL(16), values);
+}
+
+size_t palette_bytes(struct palette* p) {
+	assert(p);
+
+	return p->bits ? palette_buffer_size(p->bits) : 0;
+}
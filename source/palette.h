@@ -0,0 +1,60 @@
+/*
+	Copyright (c) 2025 Lunna5
+
+	This file is part of CavEX.
+
+	CavEX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	CavEX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with CavEX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PALETTE_H
+#define PALETTE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "pool.h"
+
+#define PALETTE_LENGTH 4096
+#define PALETTE_MAX_ENTRIES 256
+
+/* PALETTE_LENGTH values of up to 16 bit, stored as 1, 2, 4 or 8 bit indices
+ * into a local list of entries, as a single value while all are equal or as
+ * plain values once there are more than PALETTE_MAX_ENTRIES different ones */
+struct palette {
+	uint16_t* entries;
+	uint8_t* data;
+	// the only value while bits is 0
+	uint16_t uniform;
+	uint16_t length;
+	// 0, 1, 2, 4, 8 or 16 for plain values
+	uint8_t bits;
+};
+
+void palette_pool_init(void);
+void palette_get_pool_stats(struct pool_stats* stats);
+
+void palette_init(struct palette* p, uint16_t value);
+void palette_destroy(struct palette* p);
+// dst gets its own buffer, src is left untouched
+void palette_copy(struct palette* dst, struct palette* src);
+uint16_t palette_get(struct palette* p, size_t index);
+void palette_get_range(struct palette* p, size_t index, size_t count,
+					   uint16_t* out);
+void palette_set(struct palette* p, size_t index, uint16_t value);
+// replaces all PALETTE_LENGTH values at once
+void palette_fill(struct palette* p, const uint16_t* values);
+size_t palette_bytes(struct palette* p);
+
+#endif
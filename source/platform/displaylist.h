@@ -24,12 +24,35 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#ifdef PLATFORM_PC
+// texture coordinates can wrap around inside a single atlas tile
+#define DISPLAYLIST_TEXCOORD_REPEAT
+#endif
+
+#define DISPLAYLIST_BATCH_MAX 13
+
 struct displaylist {
 	void* data;
 	size_t length;
 	size_t index;
 	bool finished;
+	// storage belongs to a displaylist_batch and can't grow
+	bool fixed;
+#ifdef PLATFORM_PC
+	int vbo;
+#endif
+};
+
+// several lists sharing one allocation, each filled through its own writer
+struct displaylist_batch {
+	void* data;
+	size_t length;
+	size_t count;
+	size_t offset[DISPLAYLIST_BATCH_MAX];
+	size_t vertices[DISPLAYLIST_BATCH_MAX];
+	bool finished;
 #ifdef PLATFORM_PC
+	bool uploaded;
 	int vbo;
 #endif
 };
@@ -42,8 +65,27 @@ void displaylist_finalize(struct displaylist* l, uint16_t vtxcnt);
 void displaylist_render(struct displaylist* l);
 void displaylist_render_immediate(struct displaylist* l, uint16_t vtxcnt);
 
+void displaylist_batch_init(struct displaylist_batch* b, size_t count,
+							const size_t* vertices, size_t vertex_size);
+void displaylist_batch_writer(struct displaylist_batch* b, size_t index,
+							  struct displaylist* l);
+void displaylist_batch_finalize(struct displaylist_batch* b,
+								struct displaylist* writers);
+// for batches whose data was filled in directly, e.g. read back from disk
+void displaylist_batch_finalize_raw(struct displaylist_batch* b);
+void displaylist_batch_destroy(struct displaylist_batch* b);
+void displaylist_batch_render(struct displaylist_batch* b,
+							  const uint8_t* lists, size_t count);
+size_t displaylist_batch_bytes(struct displaylist_batch* b);
+// bytes that growing every list on its own would have allocated on top
+size_t displaylist_batch_saved(struct displaylist_batch* b);
+
 void displaylist_pos(struct displaylist* l, int16_t x, int16_t y, int16_t z);
 void displaylist_color(struct displaylist* l, uint8_t index);
 void displaylist_texcoord(struct displaylist* l, uint8_t s, uint8_t t);
+#ifdef DISPLAYLIST_TEXCOORD_REPEAT
+void displaylist_texcoord_repeat(struct displaylist* l, uint8_t tile_x,
+								 uint8_t tile_y, uint16_t s, uint16_t t);
+#endif
 
 #endif
@@ -65,6 +65,8 @@ void gfx_mode_world(void);
 void gfx_mode_gui(void);
 void gfx_fog_color(uint8_t r, uint8_t g, uint8_t b);
 void gfx_fog_pos(float dx, float dz, float distance);
+// also fogs everything closer than distance, fading out beyond, 0 disables
+void gfx_fog_fade_in(float distance);
 void gfx_fog(bool enable);
 void gfx_blending(enum gfx_blend mode);
 void gfx_alpha_test(bool enable);
@@ -83,4 +85,9 @@ void gfx_draw_quads(size_t vertex_count, const int16_t* vertices,
 void gfx_draw_quads_flt(size_t vertex_count, const float* vertices,
 						const uint8_t* colors, const float* texcoords);
 
+#ifdef PLATFORM_PC
+// scale of position and texcoord attributes, for fixed point vertex data
+void gfx_vertex_scale(float pos, float texcoord);
+#endif
+
 #endif
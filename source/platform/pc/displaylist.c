@@ -23,20 +23,30 @@
 #include <string.h>
 
 #include "../displaylist.h"
+#include "../gfx.h"
 
 #define MEM_U8(b, i) (*((uint8_t*)(b) + (i)))
 #define MEM_U16(b, i) (*(uint16_t*)((uint8_t*)(b) + (i)))
 #define MEM_I16(b, i) (*(int16_t*)((uint8_t*)(b) + (i)))
-#define MEM_FLT(b, i) (*(float*)((uint8_t*)(b) + (i)))
+
+/* s16 position, 2x u8 light, 2x u16 texcoord, positions and texcoords have 8
+ * fraction bits like GX_VTXFMT0 on the Wii */
+#define VERTEX_SIZE 12
+#define VERTEX_FRACTION (1.0F / 256.0F)
+
+/* tile index and offset inside the tile are both recovered in the vertex
+ * shader, offset keeps a margin of 128 to the next tile for rounding */
+#define TEXCOORD_REPEAT(tile, s) (((tile) + 1) * 512 + 128 + (s))
 
 void displaylist_init(struct displaylist* l, size_t vertices,
 					  size_t vertex_size) {
 	assert(l && vertices > 0 && vertex_size > 0);
 
-	l->length = 4096;
+	l->length = vertices * VERTEX_SIZE;
 	l->data = NULL;
 	l->index = 0;
 	l->finished = false;
+	l->fixed = false;
 }
 
 void displaylist_destroy(struct displaylist* l) {
@@ -68,18 +78,19 @@ void displaylist_pos(struct displaylist* l, int16_t x, int16_t y, int16_t z) {
 		assert(l->data);
 	}
 
-	if(l->index + 22 > l->length) {
+	if(l->index + VERTEX_SIZE > l->length) {
+		assert(!l->fixed);
 		l->length *= 2;
 		l->data = realloc(l->data, l->length);
 		assert(l->data);
 	}
 
-	MEM_FLT(l->data, l->index) = (float)x / 256.0F;
-	l->index += 4;
-	MEM_FLT(l->data, l->index) = (float)y / 256.0F;
-	l->index += 4;
-	MEM_FLT(l->data, l->index) = (float)z / 256.0F;
-	l->index += 4;
+	MEM_I16(l->data, l->index) = x;
+	l->index += 2;
+	MEM_I16(l->data, l->index) = y;
+	l->index += 2;
+	MEM_I16(l->data, l->index) = z;
+	l->index += 2;
 }
 
 void displaylist_color(struct displaylist* l, uint8_t index) {
@@ -91,10 +102,27 @@ void displaylist_color(struct displaylist* l, uint8_t index) {
 
 void displaylist_texcoord(struct displaylist* l, uint8_t s, uint8_t t) {
 	assert(l && !l->finished && l->data);
-	MEM_FLT(l->data, l->index) = (float)s / 256.0F;
-	l->index += 4;
-	MEM_FLT(l->data, l->index) = (float)t / 256.0F;
-	l->index += 4;
+	MEM_U16(l->data, l->index) = s;
+	l->index += 2;
+	MEM_U16(l->data, l->index) = t;
+	l->index += 2;
+}
+
+void displaylist_texcoord_repeat(struct displaylist* l, uint8_t tile_x,
+								 uint8_t tile_y, uint16_t s, uint16_t t) {
+	assert(l && !l->finished && l->data && s <= 256 && t <= 256);
+	MEM_U16(l->data, l->index) = TEXCOORD_REPEAT(tile_x, s);
+	l->index += 2;
+	MEM_U16(l->data, l->index) = TEXCOORD_REPEAT(tile_y, t);
+	l->index += 2;
+}
+
+static void displaylist_attributes(void* base) {
+	glVertexAttribPointer(0, 3, GL_SHORT, GL_FALSE, VERTEX_SIZE, base);
+	glVertexAttribPointer(3, 2, GL_UNSIGNED_BYTE, GL_FALSE, VERTEX_SIZE,
+						  (uint8_t*)base + 6);
+	glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_FALSE, VERTEX_SIZE,
+						  (uint8_t*)base + 8);
 }
 
 void displaylist_render(struct displaylist* l) {
@@ -105,7 +133,8 @@ void displaylist_render(struct displaylist* l) {
 
 		glGenBuffers(1, &l->vbo);
 		glBindBuffer(GL_ARRAY_BUFFER, l->vbo);
-		glBufferData(GL_ARRAY_BUFFER, l->index * 22, l->data, GL_STATIC_DRAW);
+		glBufferData(GL_ARRAY_BUFFER, l->index * VERTEX_SIZE, l->data,
+					 GL_STATIC_DRAW);
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 	}
 
@@ -114,14 +143,12 @@ void displaylist_render(struct displaylist* l) {
 	glEnableVertexAttribArray(2);
 
 	glBindBuffer(GL_ARRAY_BUFFER, l->vbo);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 22, NULL);
-	glVertexAttribPointer(3, 2, GL_UNSIGNED_BYTE, GL_FALSE, 22,
-						  (uint8_t*)(3 * sizeof(float)));
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 22,
-						  (uint8_t*)(2 + 3 * sizeof(float)));
+	displaylist_attributes(NULL);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
+	gfx_vertex_scale(VERTEX_FRACTION, VERTEX_FRACTION);
 	glDrawArrays(GL_QUADS, 0, l->index);
+	gfx_vertex_scale(1.0F, 1.0F);
 
 	glDisableVertexAttribArray(0);
 	glDisableVertexAttribArray(3);
@@ -134,15 +161,141 @@ void displaylist_render_immediate(struct displaylist* l, uint16_t vtxcnt) {
 	glEnableVertexAttribArray(3);
 	glEnableVertexAttribArray(2);
 
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 22, l->data);
-	glVertexAttribPointer(3, 2, GL_UNSIGNED_BYTE, GL_FALSE, 22,
-						  (uint8_t*)l->data + 3 * sizeof(float));
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 22,
-						  (uint8_t*)l->data + 2 + 3 * sizeof(float));
+	displaylist_attributes(l->data);
 
+	gfx_vertex_scale(VERTEX_FRACTION, VERTEX_FRACTION);
 	glDrawArrays(GL_QUADS, 0, vtxcnt);
+	gfx_vertex_scale(1.0F, 1.0F);
+
+	glDisableVertexAttribArray(0);
+	glDisableVertexAttribArray(3);
+	glDisableVertexAttribArray(2);
+}
+
+void displaylist_batch_init(struct displaylist_batch* b, size_t count,
+							const size_t* vertices, size_t vertex_size) {
+	assert(b && count <= DISPLAYLIST_BATCH_MAX && vertices && vertex_size > 0);
+
+	b->count = count;
+	b->length = 0;
+	b->finished = false;
+	b->uploaded = false;
+
+	for(size_t k = 0; k < count; k++) {
+		b->offset[k] = b->length;
+		b->vertices[k] = vertices[k];
+		b->length += vertices[k] * VERTEX_SIZE;
+	}
+
+	b->data = b->length > 0 ? malloc(b->length) : NULL;
+	assert(b->length == 0 || b->data);
+}
+
+void displaylist_batch_writer(struct displaylist_batch* b, size_t index,
+							  struct displaylist* l) {
+	assert(b && index < b->count && l && !b->finished);
+
+	l->data = b->vertices[index] > 0 ? (uint8_t*)b->data + b->offset[index] :
+									   NULL;
+	l->length = b->vertices[index] * VERTEX_SIZE;
+	l->index = 0;
+	l->finished = false;
+	l->fixed = true;
+}
+
+void displaylist_batch_finalize(struct displaylist_batch* b,
+								struct displaylist* writers) {
+	assert(b && writers && !b->finished);
+
+	for(size_t k = 0; k < b->count; k++) {
+		assert(writers[k].index == b->vertices[k] * VERTEX_SIZE);
+		writers[k].finished = true;
+	}
+
+	b->finished = true;
+}
+
+void displaylist_batch_finalize_raw(struct displaylist_batch* b) {
+	assert(b && !b->finished);
+	b->finished = true;
+}
+
+void displaylist_batch_destroy(struct displaylist_batch* b) {
+	assert(b);
+
+	if(b->data)
+		free(b->data);
+
+	if(b->uploaded)
+		glDeleteBuffers(1, &b->vbo);
+}
+
+void displaylist_batch_render(struct displaylist_batch* b,
+							  const uint8_t* lists, size_t count) {
+	assert(b && b->finished && lists);
+
+	if(!b->uploaded) {
+		if(!b->data)
+			return;
+
+		b->uploaded = true;
+
+		glGenBuffers(1, &b->vbo);
+		glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+		glBufferData(GL_ARRAY_BUFFER, b->length, b->data, GL_STATIC_DRAW);
+
+		// only the gpu copy is needed from now on
+		free(b->data);
+		b->data = NULL;
+	} else {
+		glBindBuffer(GL_ARRAY_BUFFER, b->vbo);
+	}
+
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(3);
+	glEnableVertexAttribArray(2);
+
+	displaylist_attributes(NULL);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	gfx_vertex_scale(VERTEX_FRACTION, VERTEX_FRACTION);
+
+	for(size_t k = 0; k < count; k++) {
+		assert(lists[k] < b->count);
+		glDrawArrays(GL_QUADS, b->offset[lists[k]] / VERTEX_SIZE,
+					 b->vertices[lists[k]]);
+	}
+
+	gfx_vertex_scale(1.0F, 1.0F);
 
 	glDisableVertexAttribArray(0);
 	glDisableVertexAttribArray(3);
 	glDisableVertexAttribArray(2);
 }
+
+size_t displaylist_batch_bytes(struct displaylist_batch* b) {
+	assert(b);
+	return b->length;
+}
+
+size_t displaylist_batch_saved(struct displaylist_batch* b) {
+	assert(b);
+
+	size_t saved = 0;
+
+	// a list used to start at 4096 bytes and double whenever it was full
+	for(size_t k = 0; k < b->count; k++) {
+		size_t exact = b->vertices[k] * VERTEX_SIZE;
+
+		if(exact > 0) {
+			size_t grown = 4096;
+
+			while(grown < exact)
+				grown *= 2;
+
+			saved += grown - exact;
+		}
+	}
+
+	return saved;
+}
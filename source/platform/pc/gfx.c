@@ -156,6 +156,7 @@ void gfx_setup() {
 	gfx_clear_buffers(255, 255, 255);
 	gfx_texture(true);
 	gfx_alpha_test(true);
+	gfx_vertex_scale(1.0F, 1.0F);
 
 	glCullFace(GL_BACK);
 	glFrontFace(GL_CW);
@@ -292,6 +293,16 @@ void gfx_fog_pos(float dx, float dz, float distance) {
 	glUniform1f(glGetUniformLocation(shader_prog, "fog_distance"), distance);
 }
 
+void gfx_fog_fade_in(float distance) {
+	assert(distance >= 0);
+	glUniform1f(glGetUniformLocation(shader_prog, "fog_fade_in"), distance);
+}
+
+void gfx_vertex_scale(float pos, float texcoord) {
+	glUniform2f(glGetUniformLocation(shader_prog, "vertex_scale"), pos,
+				texcoord);
+}
+
 void gfx_fog(bool enable) {
 	glUniform1i(glGetUniformLocation(shader_prog, "enable_fog"), enable);
 }
@@ -27,6 +27,10 @@
 #include <string.h>
 #include <unistd.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
 void thread_create(struct thread* t, void* (*entry)(void* arg), void* arg,
 				   uint8_t priority) {
 	assert(t && entry);
@@ -42,6 +46,37 @@ void thread_msleep(size_t ms) {
 	usleep(ms * 1000);
 }
 
+size_t thread_hardware_concurrency() {
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	long count = info.dwNumberOfProcessors;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	return count > 0 ? (size_t)count : 1;
+}
+
+void tmutex_init(struct thread_mutex* m) {
+	assert(m);
+	pthread_mutex_init(&m->native, NULL);
+}
+
+void tmutex_destroy(struct thread_mutex* m) {
+	assert(m);
+	pthread_mutex_destroy(&m->native);
+}
+
+void tmutex_lock(struct thread_mutex* m) {
+	assert(m);
+	pthread_mutex_lock(&m->native);
+}
+
+void tmutex_unlock(struct thread_mutex* m) {
+	assert(m);
+	pthread_mutex_unlock(&m->native);
+}
+
 void tchannel_init(struct thread_channel* c, size_t count) {
 	assert(c && count > 0);
 
@@ -129,6 +164,30 @@ void thread_msleep(size_t ms) {
 	usleep(ms * 1000);
 }
 
+size_t thread_hardware_concurrency() {
+	return 1;
+}
+
+void tmutex_init(struct thread_mutex* m) {
+	assert(m);
+	LWP_MutexInit(&m->native, false);
+}
+
+void tmutex_destroy(struct thread_mutex* m) {
+	assert(m);
+	LWP_MutexDestroy(m->native);
+}
+
+void tmutex_lock(struct thread_mutex* m) {
+	assert(m);
+	LWP_MutexLock(m->native);
+}
+
+void tmutex_unlock(struct thread_mutex* m) {
+	assert(m);
+	LWP_MutexUnlock(m->native);
+}
+
 void tchannel_init(struct thread_channel* c, size_t count) {
 	assert(c && count > 0);
 	MQ_Init(&c->native, count);
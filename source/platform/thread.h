@@ -39,6 +39,10 @@ struct thread_channel {
 	size_t length;
 };
 
+struct thread_mutex {
+	pthread_mutex_t native;
+};
+
 #endif
 
 #ifdef PLATFORM_WII
@@ -52,12 +56,22 @@ struct thread {
 struct thread_channel {
 	mqbox_t native;
 };
+
+struct thread_mutex {
+	mutex_t native;
+};
 #endif
 
 void thread_create(struct thread* t, void* (*entry)(void* arg), void* arg,
 				   uint8_t priority);
 void thread_join(struct thread* t);
 void thread_msleep(size_t ms);
+size_t thread_hardware_concurrency(void);
+
+void tmutex_init(struct thread_mutex* m);
+void tmutex_destroy(struct thread_mutex* m);
+void tmutex_lock(struct thread_mutex* m);
+void tmutex_unlock(struct thread_mutex* m);
 
 void tchannel_init(struct thread_channel* c, size_t count);
 void tchannel_close(struct thread_channel* c);
@@ -43,6 +43,7 @@ void displaylist_init(struct displaylist* l, size_t vertices,
 	 * by realloc */
 	l->index = DISPLAYLIST_CLL + 3;
 	l->finished = false;
+	l->fixed = false;
 }
 
 void displaylist_destroy(struct displaylist* l) {
@@ -79,6 +80,7 @@ void displaylist_pos(struct displaylist* l, int16_t x, int16_t y, int16_t z) {
 	}
 
 	if(l->index + 9 > l->length) {
+		assert(!l->fixed);
 		l->length = (l->length * 5 / 4 + 9 + DISPLAYLIST_CLL - 1)
 			/ DISPLAYLIST_CLL * DISPLAYLIST_CLL;
 		l->data = realloc(l->data, l->length + DISPLAYLIST_CLL);
@@ -129,3 +131,135 @@ void displaylist_render_immediate(struct displaylist* l, uint16_t vtxcnt) {
 	}
 	GX_End();
 }
+
+void displaylist_batch_init(struct displaylist_batch* b, size_t count,
+							const size_t* vertices, size_t vertex_size) {
+	assert(b && count <= DISPLAYLIST_BATCH_MAX && vertices && vertex_size > 0);
+
+	b->count = count;
+	b->length = 0;
+	b->finished = false;
+
+	/* every list starts on its own cache line, as GX_CallDispList requires,
+	 * after one line in front that stands in for a writer's padding */
+	for(size_t k = 0; k < count; k++) {
+		b->offset[k] = DISPLAYLIST_CLL + b->length;
+		b->vertices[k] = vertices[k];
+
+		if(vertices[k] > 0)
+			b->length += DISPLAYLIST_CACHE_LINES(vertices[k], vertex_size);
+	}
+
+	if(b->length > 0)
+		b->length += DISPLAYLIST_CLL;
+
+	b->data = b->length > 0 ? memalign(DISPLAYLIST_CLL, b->length) : NULL;
+	assert(b->length == 0 || b->data);
+
+	if(b->data)
+		memset(b->data, GX_NOP, DISPLAYLIST_CLL);
+}
+
+void displaylist_batch_writer(struct displaylist_batch* b, size_t index,
+							  struct displaylist* l) {
+	assert(b && index < b->count && l && !b->finished);
+
+	if(b->vertices[index] > 0) {
+		/* same layout as a standalone list, whose padding in front is
+		 * the reserved first line or the end of the previous list */
+		size_t next = (index + 1 < b->count) ? b->offset[index + 1] : b->length;
+		l->data = (uint8_t*)b->data + b->offset[index] - DISPLAYLIST_CLL;
+		l->length = next - b->offset[index] + DISPLAYLIST_CLL;
+	} else {
+		l->data = NULL;
+		l->length = 0;
+	}
+
+	l->index = DISPLAYLIST_CLL + 3;
+	l->finished = false;
+	l->fixed = true;
+}
+
+void displaylist_batch_finalize(struct displaylist_batch* b,
+								struct displaylist* writers) {
+	assert(b && writers && !b->finished);
+
+	for(size_t k = 0; k < b->count; k++) {
+		struct displaylist* l = writers + k;
+
+		if(b->vertices[k] > 0) {
+			assert(l->index == DISPLAYLIST_CLL + 3 + b->vertices[k] * 9);
+			MEM_U8(l->data, DISPLAYLIST_CLL) = GX_QUADS | (GX_VTXFMT0 & 7);
+			MEM_U16(l->data, DISPLAYLIST_CLL + 1) = b->vertices[k];
+			memset((uint8_t*)l->data + l->index, GX_NOP,
+				   l->length - l->index);
+		}
+
+		l->finished = true;
+	}
+
+	if(b->data)
+		DCStoreRange(b->data, b->length);
+
+	b->finished = true;
+}
+
+void displaylist_batch_finalize_raw(struct displaylist_batch* b) {
+	assert(b && !b->finished);
+
+	if(b->data)
+		DCStoreRange(b->data, b->length);
+
+	b->finished = true;
+}
+
+void displaylist_batch_destroy(struct displaylist_batch* b) {
+	assert(b);
+
+	if(b->data)
+		free(b->data);
+}
+
+void displaylist_batch_render(struct displaylist_batch* b,
+							  const uint8_t* lists, size_t count) {
+	assert(b && b->finished && lists);
+
+	for(size_t k = 0; k < count; k++) {
+		size_t idx = lists[k];
+		assert(idx < b->count);
+
+		if(b->vertices[idx] > 0) {
+			size_t next = (idx + 1 < b->count) ? b->offset[idx + 1] : b->length;
+			GX_CallDispList((uint8_t*)b->data + b->offset[idx],
+							next - b->offset[idx]);
+		}
+	}
+}
+
+size_t displaylist_batch_bytes(struct displaylist_batch* b) {
+	assert(b);
+	return b->length;
+}
+
+size_t displaylist_batch_saved(struct displaylist_batch* b) {
+	assert(b);
+
+	size_t saved = 0;
+
+	/* a list used to start at 64 vertices, grow by a quarter whenever it was
+	 * full and carry its own line of padding */
+	for(size_t k = 0; k < b->count; k++) {
+		if(b->vertices[k] > 0) {
+			size_t grown = DISPLAYLIST_CACHE_LINES(64, 9);
+
+			while(grown < DISPLAYLIST_CLL + 3 + b->vertices[k] * 9)
+				grown = (grown * 5 / 4 + 9 + DISPLAYLIST_CLL - 1)
+					/ DISPLAYLIST_CLL * DISPLAYLIST_CLL;
+
+			saved += grown + DISPLAYLIST_CLL
+				- DISPLAYLIST_CACHE_LINES(b->vertices[k], 9);
+		}
+	}
+
+	return saved;
+}
@@ -381,6 +381,11 @@ void gfx_fog_pos(float dx, float dz, float distance) {
 	}
 }
 
+void gfx_fog_fade_in(float distance) {
+	assert(distance >= 0);
+	// the fog texture has a single edge, far terrain pops in instead
+}
+
 void gfx_fog(bool enable) {
 	if(enable != gfx_fog_prev) {
 		GX_SetNumTexGens(enable ? 2 : 1);
@@ -0,0 +1,135 @@
+/*
+	Copyright (c) 2025 Lunna5
+
+	This file is part of CavEX.
+
+	CavEX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	CavEX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with CavEX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "pool.h"
+
+// keeps elements aligned like malloc would
+#define POOL_ALIGN 16
+#define POOL_ROUND(x) (((x) + POOL_ALIGN - 1) / POOL_ALIGN * POOL_ALIGN)
+#define POOL_HEADER POOL_ROUND(sizeof(struct pool_slab))
+
+struct pool_slab {
+	struct pool_slab* next;
+};
+
+struct pool_element {
+	struct pool_element* next;
+};
+
+// needs the lock held
+static void pool_grow(struct pool* p, size_t count) {
+	uint8_t* slab = malloc(POOL_HEADER + count * p->element_size);
+	assert(slab);
+
+	((struct pool_slab*)slab)->next = p->slabs;
+	p->slabs = slab;
+
+	uint8_t* elements = slab + POOL_HEADER;
+
+	for(size_t k = 0; k < count; k++) {
+		struct pool_element* e
+			= (struct pool_element*)(elements + k * p->element_size);
+		e->next = p->free;
+		p->free = e;
+	}
+
+	p->stats.capacity += count;
+}
+
+void pool_create(struct pool* p, size_t element_size, size_t reserve) {
+	assert(p && element_size > 0);
+
+	tmutex_init(&p->lock);
+	p->element_size = POOL_ROUND(element_size);
+	p->free = NULL;
+	p->slabs = NULL;
+	p->stats = (struct pool_stats) {0};
+
+	if(reserve > 0)
+		pool_grow(p, reserve);
+}
+
+void pool_destroy(struct pool* p) {
+	assert(p && !p->stats.in_use);
+
+	while(p->slabs) {
+		struct pool_slab* next = ((struct pool_slab*)p->slabs)->next;
+		free(p->slabs);
+		p->slabs = next;
+	}
+
+	tmutex_destroy(&p->lock);
+}
+
+void pool_reserve(struct pool* p, size_t count) {
+	assert(p);
+
+	tmutex_lock(&p->lock);
+
+	if(p->stats.capacity < count)
+		pool_grow(p, count - p->stats.capacity);
+
+	tmutex_unlock(&p->lock);
+}
+
+void* pool_alloc(struct pool* p) {
+	assert(p);
+
+	tmutex_lock(&p->lock);
+
+	if(p->free) {
+		p->stats.hits++;
+	} else {
+		p->stats.misses++;
+		pool_grow(p, 1);
+	}
+
+	struct pool_element* e = p->free;
+	p->free = e->next;
+	p->stats.in_use++;
+
+	tmutex_unlock(&p->lock);
+
+	return e;
+}
+
+void pool_free(struct pool* p, void* ptr) {
+	assert(p && ptr);
+
+	tmutex_lock(&p->lock);
+
+	struct pool_element* e = ptr;
+	e->next = p->free;
+	p->free = e;
+	p->stats.in_use--;
+
+	tmutex_unlock(&p->lock);
+}
+
+void pool_get_stats(struct pool* p, struct pool_stats* stats) {
+	assert(p && stats);
+
+	tmutex_lock(&p->lock);
+	*stats = p->stats;
+	tmutex_unlock(&p->lock);
+}
@@ -0,0 +1,51 @@
+/*
+	Copyright (c) 2025 Lunna5
+
+	This file is part of CavEX.
+
+	CavEX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	CavEX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with CavEX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+
+#include "platform/thread.h"
+
+struct pool_stats {
+	// allocations served from the freelist or not
+	size_t hits;
+	size_t misses;
+	size_t in_use;
+	size_t capacity;
+};
+
+// fixed size objects, kept on a freelist instead of going back to the heap
+struct pool {
+	struct thread_mutex lock;
+	size_t element_size;
+	void* free;
+	void* slabs;
+	struct pool_stats stats;
+};
+
+void pool_create(struct pool* p, size_t element_size, size_t reserve);
+void pool_destroy(struct pool* p);
+void pool_reserve(struct pool* p, size_t count);
+void* pool_alloc(struct pool* p);
+void pool_free(struct pool* p, void* ptr);
+void pool_get_stats(struct pool* p, struct pool_stats* stats);
+
+#endif
@@ -91,6 +91,14 @@ void stack_clear(struct stack* stk) {
 	stk->index = 0;
 }
 
+void stack_drop_front(struct stack* stk, size_t count) {
+	assert(stk != NULL && count <= stk->index);
+
+	memmove(stk->data, (uint8_t*)stk->data + count * stk->element_size,
+			(stk->index - count) * stk->element_size);
+	stk->index -= count;
+}
+
 void stack_destroy(struct stack* stk) {
 	assert(stk != NULL);
 
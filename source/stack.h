@@ -44,6 +44,9 @@ bool stack_pop(struct stack* stk, void* obj);
 
 void stack_clear(struct stack* stk);
 
+// removes the count oldest elements and keeps the order of the rest
+void stack_drop_front(struct stack* stk, size_t count);
+
 void stack_destroy(struct stack* stk);
 
 #endif
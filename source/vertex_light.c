@@ -0,0 +1,201 @@
+/*
+	Copyright (c) 2025 Lunna5
+
+	This file is part of CavEX.
+
+	CavEX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	CavEX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with CavEX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "vertex_light.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define S VERTEX_LIGHT_SIZE
+
+// the four voxels around a vertex are at i and i + offset
+static const size_t plane_offsets[3][3] = {
+	{1, S, S + 1},			 // x, z
+	{S, S * S, S * S + S},	 // z, y
+	{1, S * S, S * S + 1},	 // x, y
+};
+
+void vertex_light_compute_scalar(const uint8_t* passes, const uint8_t* sky,
+								 const uint8_t* torch, uint8_t* out) {
+	assert(passes && sky && torch && out);
+
+	const int shade_table[5] = {0, 5, 3, 1, 0};
+
+	for(int p = 0; p < 3; p++) {
+		const size_t* o = plane_offsets[p];
+
+		for(size_t i = 0; i < VERTEX_LIGHT_VOLUME; i++) {
+			int count = passes[i] + passes[i + o[0]] + passes[i + o[1]]
+				+ passes[i + o[2]];
+			int sum_sky
+				= sky[i] + sky[i + o[0]] + sky[i + o[1]] + sky[i + o[2]];
+			int sum_torch = torch[i] + torch[i + o[0]] + torch[i + o[1]]
+				+ torch[i + o[2]];
+
+			sum_torch = count > 0 ? (sum_torch + count - 1) / count : 0;
+			sum_sky = count > 0 ? (sum_sky + count - 1) / count : 0;
+			sum_torch = sum_torch > shade_table[count] ?
+				sum_torch - shade_table[count] :
+				0;
+			sum_sky = sum_sky > shade_table[count] ?
+				sum_sky - shade_table[count] :
+				0;
+
+			out[p * VERTEX_LIGHT_VOLUME + i] = (sum_torch << 4) | sum_sky;
+		}
+	}
+}
+
+/* Rounded up average of at most four light levels, minus the shading for
+ * occluded corners. Sums stay below 64, so division by 3 is (n * 43) >> 7. */
+#if defined(__SSE2__)
+
+static inline __m128i load_u16(const uint8_t* src) {
+	return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)src),
+							 _mm_setzero_si128());
+}
+
+static inline __m128i average_shade(__m128i count, __m128i sum) {
+	__m128i m1 = _mm_cmpeq_epi16(count, _mm_set1_epi16(1));
+	__m128i m2 = _mm_cmpeq_epi16(count, _mm_set1_epi16(2));
+	__m128i m3 = _mm_cmpeq_epi16(count, _mm_set1_epi16(3));
+	__m128i m4 = _mm_cmpeq_epi16(count, _mm_set1_epi16(4));
+
+	__m128i q2 = _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(1)), 1);
+	__m128i q3 = _mm_srli_epi16(
+		_mm_mullo_epi16(_mm_add_epi16(sum, _mm_set1_epi16(2)),
+						_mm_set1_epi16(43)),
+		7);
+	__m128i q4 = _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(3)), 2);
+
+	__m128i avg = _mm_or_si128(
+		_mm_or_si128(_mm_and_si128(m1, sum), _mm_and_si128(m2, q2)),
+		_mm_or_si128(_mm_and_si128(m3, q3), _mm_and_si128(m4, q4)));
+	__m128i shade = _mm_or_si128(
+		_mm_or_si128(_mm_and_si128(m1, _mm_set1_epi16(5)),
+					 _mm_and_si128(m2, _mm_set1_epi16(3))),
+		_mm_and_si128(m3, _mm_set1_epi16(1)));
+
+	return _mm_subs_epu16(avg, shade);
+}
+
+void vertex_light_compute(const uint8_t* passes, const uint8_t* sky,
+						  const uint8_t* torch, uint8_t* out) {
+	assert(passes && sky && torch && out);
+
+	for(int p = 0; p < 3; p++) {
+		const size_t* o = plane_offsets[p];
+
+		for(size_t i = 0; i < VERTEX_LIGHT_VOLUME; i += 8) {
+			__m128i count
+				= _mm_add_epi16(_mm_add_epi16(load_u16(passes + i),
+											  load_u16(passes + i + o[0])),
+								_mm_add_epi16(load_u16(passes + i + o[1]),
+											  load_u16(passes + i + o[2])));
+			__m128i sum_sky = _mm_add_epi16(
+				_mm_add_epi16(load_u16(sky + i), load_u16(sky + i + o[0])),
+				_mm_add_epi16(load_u16(sky + i + o[1]),
+							  load_u16(sky + i + o[2])));
+			__m128i sum_torch = _mm_add_epi16(
+				_mm_add_epi16(load_u16(torch + i), load_u16(torch + i + o[0])),
+				_mm_add_epi16(load_u16(torch + i + o[1]),
+							  load_u16(torch + i + o[2])));
+
+			__m128i light = _mm_or_si128(
+				average_shade(count, sum_sky),
+				_mm_slli_epi16(average_shade(count, sum_torch), 4));
+
+			_mm_storel_epi64(
+				(__m128i*)(out + p * VERTEX_LIGHT_VOLUME + i),
+				_mm_packus_epi16(light, _mm_setzero_si128()));
+		}
+	}
+}
+
+#elif defined(__ARM_NEON)
+
+static inline uint16x8_t load_u16(const uint8_t* src) {
+	return vmovl_u8(vld1_u8(src));
+}
+
+static inline uint16x8_t average_shade(uint16x8_t count, uint16x8_t sum) {
+	uint16x8_t m1 = vceqq_u16(count, vdupq_n_u16(1));
+	uint16x8_t m2 = vceqq_u16(count, vdupq_n_u16(2));
+	uint16x8_t m3 = vceqq_u16(count, vdupq_n_u16(3));
+	uint16x8_t m4 = vceqq_u16(count, vdupq_n_u16(4));
+
+	uint16x8_t q2 = vshrq_n_u16(vaddq_u16(sum, vdupq_n_u16(1)), 1);
+	uint16x8_t q3 = vshrq_n_u16(
+		vmulq_u16(vaddq_u16(sum, vdupq_n_u16(2)), vdupq_n_u16(43)), 7);
+	uint16x8_t q4 = vshrq_n_u16(vaddq_u16(sum, vdupq_n_u16(3)), 2);
+
+	uint16x8_t avg
+		= vorrq_u16(vorrq_u16(vandq_u16(m1, sum), vandq_u16(m2, q2)),
+					vorrq_u16(vandq_u16(m3, q3), vandq_u16(m4, q4)));
+	uint16x8_t shade
+		= vorrq_u16(vorrq_u16(vandq_u16(m1, vdupq_n_u16(5)),
+							  vandq_u16(m2, vdupq_n_u16(3))),
+					vandq_u16(m3, vdupq_n_u16(1)));
+
+	return vqsubq_u16(avg, shade);
+}
+
+void vertex_light_compute(const uint8_t* passes, const uint8_t* sky,
+						  const uint8_t* torch, uint8_t* out) {
+	assert(passes && sky && torch && out);
+
+	for(int p = 0; p < 3; p++) {
+		const size_t* o = plane_offsets[p];
+
+		for(size_t i = 0; i < VERTEX_LIGHT_VOLUME; i += 8) {
+			uint16x8_t count = vaddq_u16(
+				vaddq_u16(load_u16(passes + i), load_u16(passes + i + o[0])),
+				vaddq_u16(load_u16(passes + i + o[1]),
+						  load_u16(passes + i + o[2])));
+			uint16x8_t sum_sky = vaddq_u16(
+				vaddq_u16(load_u16(sky + i), load_u16(sky + i + o[0])),
+				vaddq_u16(load_u16(sky + i + o[1]), load_u16(sky + i + o[2])));
+			uint16x8_t sum_torch = vaddq_u16(
+				vaddq_u16(load_u16(torch + i), load_u16(torch + i + o[0])),
+				vaddq_u16(load_u16(torch + i + o[1]),
+						  load_u16(torch + i + o[2])));
+
+			uint16x8_t light
+				= vorrq_u16(average_shade(count, sum_sky),
+							vshlq_n_u16(average_shade(count, sum_torch), 4));
+
+			vst1_u8(out + p * VERTEX_LIGHT_VOLUME + i, vmovn_u16(light));
+		}
+	}
+}
+
+#else
+
+void vertex_light_compute(const uint8_t* passes, const uint8_t* sky,
+						  const uint8_t* torch, uint8_t* out) {
+	vertex_light_compute_scalar(passes, sky, torch, out);
+}
+
+#endif
@@ -0,0 +1,45 @@
+/*
+	Copyright (c) 2025 Lunna5
+
+	This file is part of CavEX.
+
+	CavEX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	CavEX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with CavEX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VERTEX_LIGHT_H
+#define VERTEX_LIGHT_H
+
+#include <stdint.h>
+
+#define VERTEX_LIGHT_SIZE 18
+#define VERTEX_LIGHT_VOLUME                                                    \
+	(VERTEX_LIGHT_SIZE * VERTEX_LIGHT_SIZE * VERTEX_LIGHT_SIZE)
+// zeroed entries required behind each input plane
+#define VERTEX_LIGHT_PADDING                                                   \
+	(VERTEX_LIGHT_SIZE * VERTEX_LIGHT_SIZE + VERTEX_LIGHT_SIZE + 1 + 7)
+#define VERTEX_LIGHT_INDEX(x, y, z)                                            \
+	((x) + ((z) + (y)*VERTEX_LIGHT_SIZE) * VERTEX_LIGHT_SIZE)
+
+/* Inputs are 18^3 planes in x, z, y order: passes is 1 where light passes a
+ * voxel, sky and torch hold its light levels and must be 0 where it does not.
+ * out receives three planes of averaged vertex light (torch << 4 | sky) for
+ * the corners shared by each voxel and its neighbours in +x/+z, +y/+z and
+ * +x/+y direction. */
+void vertex_light_compute(const uint8_t* passes, const uint8_t* sky,
+						  const uint8_t* torch, uint8_t* out);
+// reference implementation without SIMD
+void vertex_light_compute_scalar(const uint8_t* passes, const uint8_t* sky,
+								 const uint8_t* torch, uint8_t* out);
+
+#endif
@@ -18,6 +18,7 @@
 */
 
 #include <assert.h>
+#include <stdlib.h>
 
 #include "game/game_state.h"
 #include "lighting.h"
@@ -27,6 +28,9 @@
 // params depend on fog texture
 #define FOG_DIST_NO_RENDER 1.13F
 #define FOG_DIST_NO_EFFECT 0.72F
+// apart, so that chunks don't flip on every small camera move
+#define FOG_DIST_LOD_ENTER 0.86F
+#define FOG_DIST_LOD_LEAVE 0.80F
 
 #define FOG_DIST_LESS(c, dist)                                                 \
 	(glm_vec2_distance2(                                                       \
@@ -34,11 +38,105 @@
 		 (vec2) {gstate.camera.x, gstate.camera.z})                            \
 	 <= glm_pow2((dist) * gstate.config.fog_distance))
 
+#define WORLD_RING_SLOT(w, x, z)                                               \
+	((w)->ring + ((x) & (WORLD_RING_SIZE - 1))                                 \
+	 + ((z) & (WORLD_RING_SIZE - 1)) * WORLD_RING_SIZE)
+
+// most sources flooded together by world_update_lighting()
+#define WORLD_LIGHTING_BATCH 64
+
+struct world_light_source {
+	struct world_modification_entry entry;
+	// when world_set_block() was called
+	ptime_t queued;
+};
+
+// sections closer to the camera win a slot
+static void world_ring_rebuild(struct world* w) {
+	assert(w);
+
+	memset(w->ring, 0, sizeof(w->ring));
+	w->ring_overflow = false;
+
+	w_coord_t px = WCOORD_CHUNK_OFFSET((w_coord_t)floorf(gstate.camera.x));
+	w_coord_t pz = WCOORD_CHUNK_OFFSET((w_coord_t)floorf(gstate.camera.z));
+
+	dict_wsection_it_t it;
+	dict_wsection_it(it, w->sections);
+
+	while(!dict_wsection_end_p(it)) {
+		int64_t id = dict_wsection_ref(it)->key;
+		w_coord_t x = (int32_t)(id & 0xFFFFFFFF);
+		w_coord_t z = (int32_t)(id >> 32);
+		struct world_ring_slot* slot = WORLD_RING_SLOT(w, x, z);
+
+		if(slot->section) {
+			w->ring_overflow = true;
+
+			if(abs(x - px) + abs(z - pz)
+			   >= abs(slot->x - px) + abs(slot->z - pz)) {
+				dict_wsection_next(it);
+				continue;
+			}
+		}
+
+		*slot = (struct world_ring_slot) {
+			.x = x,
+			.z = z,
+			.section = &dict_wsection_ref(it)->value,
+		};
+
+		dict_wsection_next(it);
+	}
+}
+
+struct world_section* world_get_section(struct world* w, w_coord_t x,
+										w_coord_t z) {
+	assert(w);
+
+	struct world_ring_slot* slot = WORLD_RING_SLOT(w, x, z);
+
+	if(slot->section && slot->x == x && slot->z == z)
+		return slot->section;
+
+	return w->ring_overflow ?
+		dict_wsection_get(w->sections, SECTION_TO_ID(x, z)) :
+		NULL;
+}
+
+static void world_link_chunk(struct world* w, struct chunk* c) {
+	assert(w && c);
+
+	for(int k = 0; k < SIDE_MAX; k++) {
+		int x, y, z;
+		blocks_side_offset(k, &x, &y, &z);
+
+		struct chunk* other
+			= world_find_chunk(w, c->x + x * CHUNK_SIZE, c->y + y * CHUNK_SIZE,
+							   c->z + z * CHUNK_SIZE);
+		c->neighbours[k] = other;
+
+		if(other)
+			other->neighbours[blocks_side_opposite(k)] = c;
+	}
+}
+
+// chunks may stay alive after unloading, keep them from pointing to others
+static void world_unlink_chunk(struct chunk* c) {
+	assert(c);
+
+	for(int k = 0; k < SIDE_MAX; k++) {
+		if(c->neighbours[k]) {
+			c->neighbours[k]->neighbours[blocks_side_opposite(k)] = NULL;
+			c->neighbours[k] = NULL;
+		}
+	}
+}
+
 void world_unload_section(struct world* w, w_coord_t x, w_coord_t z) {
 	assert(w);
 
-	struct world_section* s
-		= dict_wsection_get(w->sections, SECTION_TO_ID(x, z));
+	struct world_section* s = world_get_section(w, x, z);
 
 	if(s) {
 		for(size_t k = 0; k < COLUMN_HEIGHT; k++) {
@@ -46,11 +144,13 @@ void world_unload_section(struct world* w, w_coord_t x, w_coord_t z) {
 			if(c) {
 				if(w->world_chunk_cache == c)
 					w->world_chunk_cache = NULL;
+				world_unlink_chunk(c);
 				chunk_unref(c);
 			}
 		}
 
 		dict_wsection_erase(w->sections, SECTION_TO_ID(x, z));
+		world_ring_rebuild(w);
 	}
 }
 
@@ -63,15 +163,20 @@ void world_unload_all(struct world* w) {
 	while(!dict_wsection_end_p(it)) {
 		struct world_section* s = &dict_wsection_ref(it)->value;
 		for(size_t k = 0; k < COLUMN_HEIGHT; k++) {
-			if(s->column[k])
+			if(s->column[k]) {
+				world_unlink_chunk(s->column[k]);
 				chunk_unref(s->column[k]);
+			}
 		}
 
 		dict_wsection_next(it);
 	}
 
 	stack_clear(&w->lighting_updates);
+	w->lighting_next = 0;
+	w->lighting_stats.pending = 0;
 	dict_wsection_reset(w->sections);
+	world_ring_rebuild(w);
 	w->world_chunk_cache = NULL;
 }
 
@@ -126,7 +231,7 @@ static void world_bfs(struct world* w, ilist_chunks_t render, float x, float y,
 
 			if(neigh && !neigh->tmp_data.visited && neigh->tmp_data.steps < 6
 			   && !(current->tmp_data.used_exit_sides & (1 << sides[s]))
-			   && (current->tmp_data.from == SIDE_MAX
+			   && (current->tmp_data.from == SIDE_MAX || !current->non_air
 				   || current->reachable[current->tmp_data.from]
 					   & (1 << sides[s]))
 			   && FOG_DIST_LESS(neigh, FOG_DIST_NO_RENDER)
@@ -152,18 +257,32 @@ void world_create(struct world* w) {
 	assert(w);
 
 	dict_wsection_init(w->sections);
+	world_ring_rebuild(w);
 	ilist_chunks_init(w->render);
 	ilist_chunks2_init(w->gpu_busy_chunks);
-	stack_create(&w->lighting_updates, 16,
-				 sizeof(struct world_modification_entry));
+	stack_create(&w->lighting_updates, 16, sizeof(struct world_light_source));
+	w->lighting_next = 0;
+	w->lighting_budget
+		= config_read_int(&gstate.config_user, "lighting.budget_us", 2000);
+	w->lighting_cost = 0.0F;
+	w->lighting_stats = (struct world_lighting_stats) {0};
 	w->world_chunk_cache = NULL;
 	w->anim_timer = time_get();
+	w->mesh_neighbour_wait
+		= config_read_int(&gstate.config_user, "mesher.neighbour_wait", 1000);
+	w->mesh_lod = config_read_int(&gstate.config_user, "mesher.lod", 1);
+	w->mesh_stats = (struct world_mesh_stats) {0};
+	w->mesh_pass = 0;
+	w->load_buffer
+		= malloc(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE * 2 * sizeof(uint16_t));
+	assert(w->load_buffer);
 }
 
 void world_destroy(struct world* w) {
 	assert(w);
 
 	world_unload_all(w);
+	free(w->load_buffer);
 	stack_destroy(&w->lighting_updates);
 	dict_wsection_clear(w->sections);
 }
@@ -173,18 +292,46 @@ size_t world_loaded_chunks(struct world* w) {
 	return dict_wsection_size(w->sections);
 }
 
+static struct block_data world_missing_block(w_coord_t y) {
+	return (struct block_data) {
+		.type = (y < WORLD_HEIGHT) ? 1 : 0,
+		.metadata = 0,
+		.sky_light = (y < WORLD_HEIGHT) ? 0 : 15,
+		.torch_light = 0,
+	};
+}
+
 struct block_data world_get_block(struct world* w, w_coord_t x, w_coord_t y,
 								  w_coord_t z) {
 	assert(w);
 	struct chunk* c = world_find_chunk(w, x, y, z);
 
 	return c ? chunk_get_block(c, W2C_COORD(x), W2C_COORD(y), W2C_COORD(z)) :
-			   (struct block_data) {
-				   .type = (y < WORLD_HEIGHT) ? 1 : 0,
-				   .metadata = 0,
-				   .sky_light = (y < WORLD_HEIGHT) ? 0 : 15,
-				   .torch_light = 0,
-			   };
+			   world_missing_block(y);
+}
+
+static void world_volume_fetch(void* chunk, w_coord_t x, w_coord_t y,
+							   w_coord_t z, struct block_data* blk) {
+	*blk = chunk ? chunk_get_block(chunk, W2C_COORD(x), W2C_COORD(y),
+								   W2C_COORD(z)) :
+				   world_missing_block(y);
+}
+
+void world_resolve_volume(struct world* w, struct block_volume* v) {
+	assert(w && v);
+
+	void** chunk = v->chunks;
+
+	for(w_coord_t y = 0; y < v->chunk_height; y++) {
+		for(w_coord_t z = 0; z < v->chunk_depth; z++) {
+			for(w_coord_t x = 0; x < v->chunk_width; x++)
+				*(chunk++) = world_find_chunk(w, (v->chunk_x + x) * CHUNK_SIZE,
+											  (v->chunk_y + y) * CHUNK_SIZE,
+											  (v->chunk_z + z) * CHUNK_SIZE);
+		}
+	}
+
+	v->fetch = world_volume_fetch;
 }
 
 w_coord_t world_get_height(struct world* w, w_coord_t x, w_coord_t z) {
@@ -192,8 +339,7 @@ w_coord_t world_get_height(struct world* w, w_coord_t x, w_coord_t z) {
 
 	w_coord_t cx = WCOORD_CHUNK_OFFSET(x);
 	w_coord_t cz = WCOORD_CHUNK_OFFSET(z);
-	struct world_section* s
-		= dict_wsection_get(w->sections, SECTION_TO_ID(cx, cz));
+	struct world_section* s = world_get_section(w, cx, cz);
 
 	return s ? s->heightmap[W2C_COORD(x) + W2C_COORD(z) * CHUNK_SIZE] : 0;
 }
@@ -201,8 +347,8 @@ w_coord_t world_get_height(struct world* w, w_coord_t x, w_coord_t z) {
 void world_copy_heightmap(struct world* w, struct chunk* c,
 						  uint8_t* heightmap) {
 	assert(w && c && heightmap);
-	struct world_section* s = dict_wsection_get(
-		w->sections, SECTION_TO_ID(c->x / CHUNK_SIZE, c->z / CHUNK_SIZE));
+	struct world_section* s
+		= world_get_section(w, c->x / CHUNK_SIZE, c->z / CHUNK_SIZE);
 	assert(s);
 
 	memcpy(heightmap, s->heightmap, sizeof(s->heightmap));
@@ -218,6 +364,29 @@ static bool wsection_heightmap_get_block(void* user, c_coord_t x, w_coord_t y,
 	return c;
 }
 
+// creates the section of column x, z too if it is not loaded yet
+static struct chunk* world_add_chunk(struct world* w, struct world_section** s,
+									 w_coord_t x, w_coord_t cy, w_coord_t z) {
+	assert(w && s);
+
+	struct chunk* c = chunk_alloc();
+	chunk_init(c, w, x * CHUNK_SIZE, cy * CHUNK_SIZE, z * CHUNK_SIZE);
+	chunk_ref(c);
+
+	if(!*s) {
+		*s = dict_wsection_safe_get(w->sections, SECTION_TO_ID(x, z));
+		assert(*s);
+		memset((*s)->heightmap, 0, sizeof((*s)->heightmap));
+		memset((*s)->column, 0, sizeof((*s)->column));
+		world_ring_rebuild(w);
+	}
+
+	assert((*s)->column[cy] == NULL);
+	(*s)->column[cy] = c;
+	world_link_chunk(w, c);
+	return c;
+}
+
 void world_set_block(struct world* w, w_coord_t x, w_coord_t y, w_coord_t z,
 					 struct block_data blk, bool light_update) {
 	assert(w);
@@ -227,38 +396,22 @@ void world_set_block(struct world* w, w_coord_t x, w_coord_t y, w_coord_t z,
 
 	if(light_update) {
 		stack_push(&w->lighting_updates,
-				   &(struct world_modification_entry) {
-					   .x = x,
-					   .y = y,
-					   .z = z,
-					   .blk = blk,
+				   &(struct world_light_source) {
+					   .entry.x = x,
+					   .entry.y = y,
+					   .entry.z = z,
+					   .entry.blk = blk,
+					   .queued = time_get(),
 				   });
 	} else {
 		w_coord_t cx = WCOORD_CHUNK_OFFSET(x);
 		w_coord_t cz = WCOORD_CHUNK_OFFSET(z);
-		struct world_section* s
-			= dict_wsection_get(w->sections, SECTION_TO_ID(cx, cz));
+		struct world_section* s = world_get_section(w, cx, cz);
 		struct chunk* c = world_chunk_from_section(w, s, y);
 
 		if(!c) {
-			c = malloc(sizeof(struct chunk));
-			assert(c);
-
-			w_coord_t cy = y / CHUNK_SIZE;
-			chunk_init(c, w, cx * CHUNK_SIZE, cy * CHUNK_SIZE, cz * CHUNK_SIZE);
-			chunk_ref(c);
-
+			c = world_add_chunk(w, &s, cx, y / CHUNK_SIZE, cz);
 			w->world_chunk_cache = c;
-
-			if(!s) {
-				s = dict_wsection_safe_get(w->sections, SECTION_TO_ID(cx, cz));
-				assert(s);
-				memset(s->heightmap, 0, sizeof(s->heightmap));
-				memset(s->column, 0, sizeof(s->column));
-			}
-
-			assert(s->column[cy] == NULL);
-			s->column[cy] = c;
 		}
 
 		chunk_set_block(c, W2C_COORD(x), W2C_COORD(y), W2C_COORD(z), blk);
@@ -267,15 +420,78 @@ void world_set_block(struct world* w, w_coord_t x, w_coord_t y, w_coord_t z,
 	}
 }
 
+void world_load_column(struct world* w, w_coord_t x, w_coord_t z,
+					   const uint8_t* ids, const uint8_t* metadata,
+					   const uint8_t* lighting_sky,
+					   const uint8_t* lighting_torch) {
+	assert(w && ids && metadata && lighting_sky && lighting_torch);
+
+	struct world_section* s = world_get_section(w, x, z);
+
+	for(w_coord_t cy = 0; cy < COLUMN_HEIGHT; cy++) {
+		if(!s || !s->column[cy])
+			world_add_chunk(w, &s, x, cy, z);
+	}
+
+	memset(s->heightmap, 0, sizeof(s->heightmap));
+
+	uint16_t* blk_buffer = w->load_buffer;
+	uint16_t* light_buffer
+		= w->load_buffer + CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE;
+
+	for(w_coord_t cy = 0; cy < COLUMN_HEIGHT; cy++) {
+		for(c_coord_t bx = 0; bx < CHUNK_SIZE; bx++) {
+			for(c_coord_t bz = 0; bz < CHUNK_SIZE; bz++) {
+				// y changes fastest, nibbles of even indices come first
+				size_t src
+					= cy * CHUNK_SIZE + (bz + bx * CHUNK_SIZE) * WORLD_HEIGHT;
+				uint8_t* height = s->heightmap + bx + bz * CHUNK_SIZE;
+
+				for(c_coord_t by = 0; by < CHUNK_SIZE; by++) {
+					size_t idx = src + by;
+					int shift = (idx % 2) * 4;
+					uint8_t type = ids[idx];
+
+					blk_buffer[CHUNK_INDEX(bx, by, bz)] = type
+						| (((metadata[idx / 2] >> shift) & 0xF) << 8);
+					light_buffer[CHUNK_INDEX(bx, by, bz)]
+						= (((lighting_torch[idx / 2] >> shift) & 0xF) << 4)
+						| ((lighting_sky[idx / 2] >> shift) & 0xF);
+
+					// same test as lighting_heightmap_update()
+					if(blocks[type]
+					   && (!blocks[type]->can_see_through
+						   || blocks[type]->opacity > 0))
+						*height = cy * CHUNK_SIZE + by + 1;
+				}
+			}
+		}
+
+		chunk_load(s->column[cy], blk_buffer, light_buffer);
+	}
+
+	// border blocks of the neighbours can have changed visibility
+	w_coord_t offsets[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+	for(int k = 0; k < 4; k++) {
+		struct world_section* other
+			= world_get_section(w, x + offsets[k][0], z + offsets[k][1]);
+
+		for(w_coord_t cy = 0; other && cy < COLUMN_HEIGHT; cy++) {
+			if(other->column[cy])
+				chunk_mark_dirty(other->column[cy]);
+		}
+	}
+}
+
 static bool world_light_get_block(void* user, w_coord_t x, w_coord_t y,
 								  w_coord_t z, struct block_data* blk,
 								  uint8_t* height) {
 	assert(user);
 	struct world* w = user;
 
-	struct world_section* s = dict_wsection_get(
-		w->sections,
-		SECTION_TO_ID(WCOORD_CHUNK_OFFSET(x), WCOORD_CHUNK_OFFSET(z)));
+	struct world_section* s
+		= world_get_section(w, WCOORD_CHUNK_OFFSET(x), WCOORD_CHUNK_OFFSET(z));
 
 	if(!s)
 		return false;
@@ -306,33 +522,70 @@ static void world_light_set_light(void* user, w_coord_t x, w_coord_t y,
 void world_update_lighting(struct world* w) {
 	assert(w);
 
-	if(stack_empty(&w->lighting_updates))
-		return;
+	ptime_t start = time_get();
+	float remaining = w->lighting_budget;
+	size_t limit = 0;
+	w->lighting_stats.latency = 0.0F;
+
+	// oldest first, so that the last change to a block wins
+	while(w->lighting_next < stack_size(&w->lighting_updates)
+		  && (!limit || remaining > 0.0F)) {
+		/* as many sources as fit into the rest of the budget, but at most
+		 * twice the last batch, a single cheap flood says little */
+		float fit = (w->lighting_cost > 0.0F) ? remaining / w->lighting_cost :
+												1.0F;
+		limit = glm_imin(glm_clamp(fit, 1.0F, WORLD_LIGHTING_BATCH),
+						 limit ? limit * 2 : 1);
+
+		struct world_modification_entry batch[WORLD_LIGHTING_BATCH];
+		size_t length = 0;
+		ptime_t oldest = start;
+
+		while(length < limit
+			  && w->lighting_next < stack_size(&w->lighting_updates)) {
+			struct world_light_source src;
+			stack_at(&w->lighting_updates, &src, w->lighting_next++);
+
+			if(length == 0)
+				oldest = src.queued;
+
+			world_set_block(w, src.entry.x, src.entry.y, src.entry.z,
+							src.entry.blk, false);
+			batch[length++] = src.entry;
+		}
 
-	struct world_modification_entry source;
-	stack_pop(&w->lighting_updates, &source);
+		ptime_t flood = time_get();
+		size_t unique = lighting_update_at_blocks(batch, length, false,
+												  world_light_get_block,
+												  world_light_set_light, w);
+		ptime_t end = time_get();
 
-	world_set_block(w, source.x, source.y, source.z, source.blk, false);
-	lighting_update_at_block(source, false, world_light_get_block,
-							 world_light_set_light, w);
-}
+		// follows expensive floods at once and cheap ones slowly
+		w->lighting_cost = glm_max(time_diff_s(flood, end) * 1e6F / unique,
+								   w->lighting_cost * 0.9F);
 
-struct chunk* world_find_chunk_neighbour(struct world* w, struct chunk* c,
-										 enum side s) {
-	assert(w && c);
+		w->lighting_stats.updated += unique;
+		w->lighting_stats.coalesced += length - unique;
+		w->lighting_stats.latency = glm_max(w->lighting_stats.latency,
+											time_diff_s(oldest, end) * 1000.0F);
 
-	int x, y, z;
-	blocks_side_offset(s, &x, &y, &z);
+		remaining = w->lighting_budget - time_diff_s(start, end) * 1e6F;
+	}
 
-	if(y + c->y / CHUNK_SIZE < 0
-	   || y + c->y / CHUNK_SIZE >= WORLD_HEIGHT / CHUNK_SIZE)
-		return NULL;
+	// keep the queue bounded while new updates arrive every frame
+	if(w->lighting_next > stack_size(&w->lighting_updates) / 2) {
+		stack_drop_front(&w->lighting_updates, w->lighting_next);
+		w->lighting_next = 0;
+	}
 
-	struct world_section* res = dict_wsection_get(
-		w->sections,
-		SECTION_TO_ID(x + c->x / CHUNK_SIZE, z + c->z / CHUNK_SIZE));
+	w->lighting_stats.pending
+		= stack_size(&w->lighting_updates) - w->lighting_next;
+}
 
-	return res ? res->column[y + c->y / CHUNK_SIZE] : NULL;
+struct chunk* world_find_chunk_neighbour(struct world* w, struct chunk* c,
+										 enum side s) {
+	assert(w && c && s < SIDE_MAX);
+	return c->neighbours[s];
 }
 
 struct chunk* world_chunk_from_section(struct world* w, struct world_section* s,
@@ -357,8 +610,7 @@ struct chunk* world_find_chunk(struct world* w, w_coord_t x, w_coord_t y,
 	   && cz == w->world_chunk_cache->z / CHUNK_SIZE)
 		return w->world_chunk_cache;
 
-	struct world_section* res
-		= dict_wsection_get(w->sections, SECTION_TO_ID(cx, cz));
+	struct world_section* res = world_get_section(w, cx, cz);
 
 	if(res)
 		w->world_chunk_cache = res->column[cy];
@@ -429,6 +681,7 @@ void world_pre_render(struct world* w, struct camera* c, mat4 view) {
 
 	ilist_chunks_it_t it;
 	ilist_chunks_it(it, w->render);
+	w->mesh_stats.lod = 0;
 
 	while(!ilist_chunks_end_p(it)) {
 		struct chunk* c = ilist_chunks_ref(it);
@@ -436,6 +689,18 @@ void world_pre_render(struct world* w, struct camera* c, mat4 view) {
 
 		chunk_pre_render(c, view, has_fog);
 
+		bool lod = c->lod ?
+			!FOG_DIST_LESS(c, FOG_DIST_LOD_LEAVE) :
+			w->mesh_lod && !FOG_DIST_LESS(c, FOG_DIST_LOD_ENTER);
+
+		if(lod != c->lod) {
+			c->lod = lod;
+			chunk_mark_dirty(c);
+		}
+
+		if(lod)
+			w->mesh_stats.lod++;
+
 		if(has_fog) {
 			ilist_chunks_remove(w->render, it);
 			ilist_chunks_push_front(w->render, c);
@@ -445,17 +710,78 @@ void world_pre_render(struct world* w, struct camera* c, mat4 view) {
 	}
 }
 
+// loaded and close enough to be drawn from its chunks
+bool world_column_in_view(struct world* w, w_coord_t x, w_coord_t z) {
+	assert(w);
+
+	struct {
+		w_coord_t x, z;
+	} c = {x * CHUNK_SIZE, z * CHUNK_SIZE};
+
+	return FOG_DIST_LESS(&c, FOG_DIST_NO_RENDER)
+		&& world_get_section(w, x, z);
+}
+
 void world_pre_render_clear(struct world* w) {
 	assert(w);
 	ilist_chunks_init(w->render);
 }
 
+static bool world_chunk_neighbours_loaded(struct world* w, struct chunk* c) {
+	assert(w && c);
+
+	int cx = c->x / CHUNK_SIZE;
+	int cz = c->z / CHUNK_SIZE;
+
+	return world_get_section(w, cx - 1, cz) && world_get_section(w, cx + 1, cz)
+		&& world_get_section(w, cx, cz - 1) && world_get_section(w, cx, cz + 1);
+}
+
+static bool world_build_chunk(struct world* w, struct chunk* c, ptime_t now) {
+	assert(w && c);
+
+	if(!c->rebuild_displist)
+		return false;
+
+	/* a chunk meshed while its neighbours are still streaming in would be
+	 * meshed again once they arrive */
+	bool complete = world_chunk_neighbours_loaded(w, c);
+
+	if(!complete && w->mesh_neighbour_wait > 0
+	   && time_diff_ms(c->dirty_since, now) < w->mesh_neighbour_wait) {
+		// visited by both loops of world_build_chunks()
+		if(c->waiting_pass != w->mesh_pass) {
+			c->waiting_pass = w->mesh_pass;
+			w->mesh_stats.waiting++;
+		}
+
+		return false;
+	}
+
+	if(!chunk_check_built(c))
+		return false;
+
+	w->mesh_stats.meshed++;
+
+	if(c->mesh_incomplete)
+		w->mesh_stats.double_meshed++;
+
+	c->mesh_incomplete = !complete;
+	return true;
+}
+
 size_t world_build_chunks(struct world* w, size_t tokens) {
+	assert(w);
+
+	ptime_t now = time_get();
+	w->mesh_stats.waiting = 0;
+	w->mesh_pass++;
+
 	ilist_chunks_it_t it;
 	ilist_chunks_it(it, w->render);
 
 	while(tokens > 0 && !ilist_chunks_end_p(it)) {
-		if(chunk_check_built(ilist_chunks_ref(it)))
+		if(world_build_chunk(w, ilist_chunks_ref(it), now))
 			tokens--;
 		ilist_chunks_next(it);
 	}
@@ -466,7 +792,7 @@ size_t world_build_chunks(struct world* w, size_t tokens) {
 	while(tokens > 0 && !dict_wsection_end_p(it2)) {
 		struct world_section* s = &dict_wsection_ref(it2)->value;
 		for(size_t k = 0; k < COLUMN_HEIGHT; k++) {
-			if(s->column[k] && chunk_check_built(s->column[k]))
+			if(s->column[k] && world_build_chunk(w, s->column[k], now))
 				tokens--;
 		}
 
@@ -567,31 +893,36 @@ bool world_aabb_intersection(struct world* w, struct AABB* a) {
 	w_coord_t max_y = ceilf(a->y2) + 1;
 	w_coord_t max_z = ceilf(a->z2) + 1;
 
-	for(w_coord_t x = min_x; x < max_x; x++) {
-		for(w_coord_t z = min_z; z < max_z; z++) {
-			for(w_coord_t y = min_y; y < max_y; y++) {
-				struct block_data blk = world_get_block(w, x, y, z);
+	struct block_volume v;
+	block_volume_init(&v, min_x, min_y, min_z, max_x, max_y, max_z);
+	world_resolve_volume(w, &v);
 
-				if(blocks[blk.type]) {
+	bool hit = false;
+
+	for(w_coord_t x = min_x; x < max_x && !hit; x++) {
+		for(w_coord_t z = min_z; z < max_z && !hit; z++) {
+			for(w_coord_t y = min_y; y < max_y && !hit; y++) {
+				struct block_data* blk = block_volume_get(&v, x, y, z);
+
+				if(blocks[blk->type]) {
 					struct block_info blk_info = (struct block_info) {
-						.block = &blk,
+						.block = blk,
 						.neighbours = NULL,
 						.x = x,
 						.y = y,
 						.z = z,
 					};
 
-					size_t count = blocks[blk.type]->getBoundingBox(&blk_info,
-																	true, NULL);
+					size_t count = blocks[blk->type]->getBoundingBox(
+						&blk_info, true, NULL);
 					if(count > 0) {
 						struct AABB bbox[count];
-						blocks[blk.type]->getBoundingBox(&blk_info, true, bbox);
+						blocks[blk->type]->getBoundingBox(&blk_info, true,
+														  bbox);
 
-						for(size_t k = 0; k < count; k++) {
+						for(size_t k = 0; k < count && !hit; k++) {
 							aabb_translate(bbox + k, x, y, z);
-
-							if(aabb_intersection(a, bbox + k))
-								return true;
+							hit = aabb_intersection(a, bbox + k);
 						}
 					}
 				}
@@ -599,7 +930,8 @@ bool world_aabb_intersection(struct world* w, struct AABB* a) {
 		}
 	}
 
-	return false;
+	block_volume_destroy(&v);
+	return hit;
 }
 
 static const float light_lookup_overworld[16] = {
@@ -37,6 +37,7 @@ typedef enum {
 } world_dim;
 
 #include "block/aabb.h"
+#include "block_volume.h"
 #include "chunk.h"
 #include "game/camera.h"
 #include "util.h"
@@ -54,20 +55,71 @@ struct world_section {
 DICT_DEF2(dict_wsection, int64_t, M_BASIC_OPLIST, struct world_section,
 		  M_POD_OPLIST)
 
+// power of two, wider than the loaded area so that sections rarely collide
+#define WORLD_RING_SIZE 32
+
+struct world_ring_slot {
+	w_coord_t x, z;
+	struct world_section* section;
+};
+
+struct world_mesh_stats {
+	size_t meshed;
+	// rebuilds of chunks first meshed with a horizontal neighbour missing
+	size_t double_meshed;
+	// chunks held back by the last world_build_chunks()
+	size_t waiting;
+	// chunks rendered by the last world_pre_render() with reduced detail
+	size_t lod;
+};
+
+struct world_lighting_stats {
+	// block changes still waiting in lighting_updates
+	size_t pending;
+	size_t updated;
+	// updates merged with another one to the same block
+	size_t coalesced;
+	// ms from a block change to its light update, worst of the last frame
+	float latency;
+};
+
 struct world {
 	dict_wsection_t sections;
+	// sections by x, z modulo WORLD_RING_SIZE, refilled on every insert or
+	// erase of the dict, which moves its values around
+	struct world_ring_slot ring[WORLD_RING_SIZE * WORLD_RING_SIZE];
+	// some sections are only found in the dict
+	bool ring_overflow;
 	struct chunk* world_chunk_cache;
 	ilist_chunks_t render;
 	ilist_chunks2_t gpu_busy_chunks;
 	ptime_t anim_timer;
+	// block changes and their light updates, done from lighting_next onwards
 	struct stack lighting_updates;
+	size_t lighting_next;
+	// us of light updates per frame, at least one batch always runs
+	int lighting_budget;
+	// measured us per flooded source, sizes the batches, 0 until known
+	float lighting_cost;
+	struct world_lighting_stats lighting_stats;
 	world_dim dimension;
+	// ms to wait for horizontal neighbours before meshing, 0 disables
+	int mesh_neighbour_wait;
+	// reduced detail meshes inside the fog
+	bool mesh_lod;
+	struct world_mesh_stats mesh_stats;
+	// bumped by every world_build_chunks()
+	uint32_t mesh_pass;
+	// blocks and light of one chunk for world_load_column()
+	uint16_t* load_buffer;
 };
 
 void world_create(struct world* w);
 void world_destroy(struct world* w);
 void world_unload_section(struct world* w, w_coord_t x, w_coord_t z);
 void world_unload_all(struct world* w);
+struct world_section* world_get_section(struct world* w, w_coord_t x,
+										w_coord_t z);
 w_coord_t world_get_height(struct world* w, w_coord_t x, w_coord_t z);
 void world_copy_heightmap(struct world* w, struct chunk* c, uint8_t* heightmap);
 size_t world_build_chunks(struct world* w, size_t tokens);
@@ -80,8 +132,15 @@ struct chunk* world_find_chunk(struct world* w, w_coord_t x, w_coord_t y,
 							   w_coord_t z);
 struct block_data world_get_block(struct world* w, w_coord_t x, w_coord_t y,
 								  w_coord_t z);
+// v then returns the same blocks as world_get_block()
+void world_resolve_volume(struct world* w, struct block_volume* v);
 void world_set_block(struct world* w, w_coord_t x, w_coord_t y, w_coord_t z,
 					 struct block_data blk, bool light_update);
+// replaces column x, z with data in the layout of struct server_chunk
+void world_load_column(struct world* w, w_coord_t x, w_coord_t z,
+					   const uint8_t* ids, const uint8_t* metadata,
+					   const uint8_t* lighting_sky,
+					   const uint8_t* lighting_torch);
 void world_update_lighting(struct world* w);
 void world_preload(struct world* w,
 				   void (*progress)(struct world* w, float percent));
@@ -89,6 +148,7 @@ bool world_block_intersection(struct world* w, struct ray* r, w_coord_t x,
 							  w_coord_t y, w_coord_t z, enum side* s);
 void world_pre_render(struct world* w, struct camera* c, mat4 view);
 void world_pre_render_clear(struct world* w);
+bool world_column_in_view(struct world* w, w_coord_t x, w_coord_t z);
 size_t world_render(struct world* w, struct camera* c, bool pass);
 bool world_aabb_intersection(struct world* w, struct AABB* a);
 size_t world_loaded_chunks(struct world* w);
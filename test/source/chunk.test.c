@@ -0,0 +1,67 @@
+/*
+	Copyright (c) 2025 Lunna5
+
+	This file is part of CavEX.
+
+	CavEX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	CavEX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with CavEX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "../../source/block/blocks.h"
+#include "../../source/chunk.h"
+#include "../../source/world.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define COLUMN_BLOCKS (CHUNK_SIZE * CHUNK_SIZE * WORLD_HEIGHT)
+
+int main(void) {
+	blocks_init();
+	chunk_pool_init(0);
+
+	struct world w;
+	world_create(&w);
+
+	// a single column of stone, all of its neighbours are missing
+	uint8_t* ids = malloc(COLUMN_BLOCKS);
+	uint8_t* nibbles = calloc(COLUMN_BLOCKS / 2, 1);
+	assert(ids && nibbles);
+	memset(ids, BLOCK_STONE, COLUMN_BLOCKS);
+	world_load_column(&w, 0, 0, ids, nibbles, nibbles, nibbles);
+
+	assert(chunk_enclosed(world_find_chunk(&w, 0, 0, 0)));
+	assert(chunk_enclosed(world_find_chunk(&w, 0, 64, 0)));
+
+	// the top section borders the air above the world
+	struct chunk* top = world_find_chunk(&w, 0, WORLD_HEIGHT - 1, 0);
+	assert(top && !chunk_enclosed(top));
+
+	struct block_data* snapshot = malloc((CHUNK_SIZE + 2) * (CHUNK_SIZE + 2)
+										 * (CHUNK_SIZE + 2)
+										 * sizeof(struct block_data));
+	assert(snapshot);
+	chunk_snapshot(top, snapshot);
+
+	for(int y = 0; y < CHUNK_SIZE + 2; y++) {
+		struct block_data* blk = snapshot
+			+ ((CHUNK_SIZE + 2) / 2 + y * (CHUNK_SIZE + 2)) * (CHUNK_SIZE + 2);
+		assert(blk->type == ((y < CHUNK_SIZE + 1) ? BLOCK_STONE : BLOCK_AIR));
+	}
+
+	free(snapshot);
+	free(ids);
+	free(nibbles);
+	world_destroy(&w);
+	return 0;
+}
@@ -0,0 +1,150 @@
+/*
+	Copyright (c) 2025 Lunna5
+
+	This file is part of CavEX.
+
+	CavEX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	CavEX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with CavEX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "../../source/block/blocks.h"
+#include "../../source/chunk.h"
+#include "../../source/chunk_mesher.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PADDED (CHUNK_SIZE + 2)
+#define INDEX(x, y, z) ((x) + ((z) + (y) * CHUNK_SIZE) * CHUNK_SIZE)
+#define VOLUME (CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE)
+
+static struct block_data snapshot[PADDED * PADDED * PADDED];
+static uint8_t types[VOLUME];
+
+static bool see_through(int x, int y, int z) {
+	uint8_t type = types[INDEX(x, y, z)];
+	return !blocks[type] || blocks[type]->can_see_through;
+}
+
+static uint8_t border_sides(int x, int y, int z) {
+	return ((x == 0) << SIDE_LEFT) | ((x == CHUNK_SIZE - 1) << SIDE_RIGHT)
+		| ((y == 0) << SIDE_BOTTOM) | ((y == CHUNK_SIZE - 1) << SIDE_TOP)
+		| ((z == 0) << SIDE_FRONT) | ((z == CHUNK_SIZE - 1) << SIDE_BACK);
+}
+
+// plain flood fill from every open block, one component at a time
+static void reference(uint8_t* reachable) {
+	static bool visited[VOLUME];
+	static uint16_t queue[VOLUME];
+
+	memset(visited, false, sizeof(visited));
+	memset(reachable, 0, 6);
+
+	for(int start = 0; start < VOLUME; start++) {
+		int sx = start % CHUNK_SIZE;
+		int sz = (start / CHUNK_SIZE) % CHUNK_SIZE;
+		int sy = start / (CHUNK_SIZE * CHUNK_SIZE);
+
+		if(visited[start] || !see_through(sx, sy, sz))
+			continue;
+
+		size_t head = 0, tail = 0;
+		uint8_t sides = 0;
+		queue[tail++] = start;
+		visited[start] = true;
+
+		while(head < tail) {
+			int k = queue[head++];
+			int x = k % CHUNK_SIZE;
+			int z = (k / CHUNK_SIZE) % CHUNK_SIZE;
+			int y = k / (CHUNK_SIZE * CHUNK_SIZE);
+			sides |= border_sides(x, y, z);
+
+			for(int s = 0; s < 6; s++) {
+				int nx, ny, nz;
+				blocks_side_offset(s, &nx, &ny, &nz);
+				nx += x;
+				ny += y;
+				nz += z;
+
+				if(nx < 0 || ny < 0 || nz < 0 || nx >= CHUNK_SIZE
+				   || ny >= CHUNK_SIZE || nz >= CHUNK_SIZE
+				   || visited[INDEX(nx, ny, nz)] || !see_through(nx, ny, nz))
+					continue;
+
+				visited[INDEX(nx, ny, nz)] = true;
+				queue[tail++] = INDEX(nx, ny, nz);
+			}
+		}
+
+		for(int s = 0; s < 6; s++) {
+			if(sides & (1 << s))
+				reachable[s] |= sides;
+		}
+	}
+}
+
+static void fill_random(unsigned seed) {
+	srand(seed);
+
+	// from almost empty to almost solid, with see-through and unknown ids
+	int solid = seed % 11;
+	uint8_t other[] = {BLOCK_GLASS, BLOCK_TORCH, 255};
+
+	for(int k = 0; k < VOLUME; k++) {
+		int r = rand() % 10;
+		types[k] = (r < solid) ?
+			BLOCK_STONE :
+			((rand() % 4) ? BLOCK_AIR : other[rand() % sizeof(other)]);
+	}
+
+	// carve a winding tunnel through some of the denser ones
+	if(seed % 3 == 0) {
+		int x = rand() % CHUNK_SIZE, y = rand() % CHUNK_SIZE,
+			z = rand() % CHUNK_SIZE;
+
+		for(int k = 0; k < 200; k++) {
+			types[INDEX(x, y, z)] = BLOCK_AIR;
+			int d = rand() % 3, step = (rand() % 2) ? 1 : -1;
+			int* c = (d == 0) ? &x : ((d == 1) ? &y : &z);
+			*c = glm_clamp(*c + step, 0, CHUNK_SIZE - 1);
+		}
+	}
+
+	for(int k = 0; k < PADDED * PADDED * PADDED; k++)
+		snapshot[k] = (struct block_data) {.type = BLOCK_STONE};
+
+	for(int y = 0; y < CHUNK_SIZE; y++) {
+		for(int z = 0; z < CHUNK_SIZE; z++) {
+			for(int x = 0; x < CHUNK_SIZE; x++)
+				snapshot[(x + 1) + ((z + 1) + (y + 1) * PADDED) * PADDED]
+					.type
+					= types[INDEX(x, y, z)];
+		}
+	}
+}
+
+int main(void) {
+	blocks_init();
+
+	for(unsigned seed = 0; seed < 300; seed++) {
+		fill_random(seed);
+
+		uint8_t expected[6], actual[6];
+		reference(expected);
+		chunk_mesher_reachable(snapshot, actual);
+		assert(memcmp(expected, actual, sizeof(actual)) == 0);
+	}
+
+	return 0;
+}
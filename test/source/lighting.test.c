@@ -0,0 +1,199 @@
+/*
+	Copyright (c) 2025 Lunna5
+
+	This file is part of CavEX.
+
+	CavEX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	CavEX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with CavEX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "../../source/block/blocks.h"
+#include "../../source/chunk.h"
+#include "../../source/lighting.h"
+#include "../../source/world.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define COLUMN_BLOCKS (CHUNK_SIZE * CHUNK_SIZE * WORLD_HEIGHT)
+#define COLUMNS 3
+#define GROUND 40
+#define CHANGES 400
+
+static struct world batched, sequential;
+static struct world_modification_entry changes[CHANGES];
+
+static bool get_block(void* user, w_coord_t x, w_coord_t y, w_coord_t z,
+					  struct block_data* blk, uint8_t* height) {
+	struct world* w = user;
+	struct world_section* s
+		= world_get_section(w, WCOORD_CHUNK_OFFSET(x), WCOORD_CHUNK_OFFSET(z));
+
+	if(!s)
+		return false;
+
+	struct chunk* c = world_chunk_from_section(w, s, y);
+
+	if(!c)
+		return false;
+
+	if(blk)
+		*blk = chunk_get_block(c, W2C_COORD(x), W2C_COORD(y), W2C_COORD(z));
+
+	if(height)
+		*height = s->heightmap[W2C_COORD(x) + W2C_COORD(z) * CHUNK_SIZE];
+
+	return true;
+}
+
+static void set_light(void* user, w_coord_t x, w_coord_t y, w_coord_t z,
+					  uint8_t light) {
+	struct chunk* c = world_find_chunk(user, x, y, z);
+	assert(c);
+	chunk_set_light(c, W2C_COORD(x), W2C_COORD(y), W2C_COORD(z), light);
+}
+
+// stone up to GROUND with full sky light above it
+static void load(struct world* w) {
+	uint8_t* ids = malloc(COLUMN_BLOCKS);
+	uint8_t* sky = malloc(COLUMN_BLOCKS / 2);
+	uint8_t* nibbles = calloc(COLUMN_BLOCKS / 2, 1);
+	assert(ids && sky && nibbles);
+
+	for(size_t k = 0; k < COLUMN_BLOCKS; k++)
+		ids[k] = (k % WORLD_HEIGHT < GROUND) ? BLOCK_STONE : BLOCK_AIR;
+
+	for(size_t k = 0; k < COLUMN_BLOCKS / 2; k++)
+		sky[k] = ((k * 2) % WORLD_HEIGHT < GROUND) ? 0x00 : 0xFF;
+
+	world_create(w);
+
+	for(w_coord_t x = 0; x < COLUMNS; x++) {
+		for(w_coord_t z = 0; z < COLUMNS; z++)
+			world_load_column(w, x, z, ids, nibbles, sky, nibbles);
+	}
+
+	free(ids);
+	free(sky);
+	free(nibbles);
+}
+
+static void change(size_t k, w_coord_t x, w_coord_t y, w_coord_t z,
+				   uint8_t type) {
+	changes[k] = (struct world_modification_entry) {
+		.x = x,
+		.y = y,
+		.z = z,
+		.blk = (struct block_data) {.type = type},
+	};
+}
+
+static void fill_changes(unsigned seed) {
+	w_coord_t mid = COLUMNS * CHUNK_SIZE / 2;
+	size_t k = 0;
+
+	// a row of adjacent torches on the ground
+	for(w_coord_t x = mid - 4; x < mid + 4; x++)
+		change(k++, x, GROUND, mid, BLOCK_TORCH);
+
+	// the same block again and again, the last change wins
+	uint8_t types[] = {BLOCK_TORCH, BLOCK_AIR, BLOCK_STONE, BLOCK_TORCH,
+					   BLOCK_GLASS, BLOCK_AIR};
+	for(size_t t = 0; t < sizeof(types); t++)
+		change(k++, mid, GROUND + 2, mid + 3, types[t]);
+
+	// a shaft that lets sky light in, then a torch at its bottom
+	for(w_coord_t y = GROUND - 1; y > GROUND - 12; y--)
+		change(k++, mid + 5, y, mid - 5, BLOCK_AIR);
+	change(k++, mid + 5, GROUND - 11, mid - 5, BLOCK_TORCH);
+
+	srand(seed);
+
+	while(k < CHANGES) {
+		if(rand() % 4 == 0) {
+			changes[k] = changes[rand() % k];
+			k++;
+			continue;
+		}
+
+		uint8_t type = (rand() % 3) ?
+			BLOCK_TORCH :
+			((rand() % 2) ? BLOCK_STONE : BLOCK_AIR);
+		change(k++, mid - 12 + rand() % 24, GROUND - 3 + rand() % 6,
+			   mid - 12 + rand() % 24, type);
+	}
+}
+
+static void compare(void) {
+	for(w_coord_t x = 0; x < COLUMNS * CHUNK_SIZE; x++) {
+		for(w_coord_t z = 0; z < COLUMNS * CHUNK_SIZE; z++) {
+			for(w_coord_t y = 0; y < WORLD_HEIGHT; y++) {
+				struct block_data a = world_get_block(&batched, x, y, z);
+				struct block_data b = world_get_block(&sequential, x, y, z);
+				assert(a.type == b.type && a.metadata == b.metadata);
+				assert(a.sky_light == b.sky_light);
+				assert(a.torch_light == b.torch_light);
+			}
+		}
+	}
+}
+
+static void run(unsigned seed, int budget) {
+	load(&batched);
+	load(&sequential);
+	fill_changes(seed);
+
+	batched.lighting_budget = budget;
+
+	// more changes arrive while the first ones are still pending
+	for(size_t k = 0; k < CHANGES / 2; k++)
+		world_set_block(&batched, changes[k].x, changes[k].y, changes[k].z,
+						changes[k].blk, true);
+
+	world_update_lighting(&batched);
+
+	for(size_t k = CHANGES / 2; k < CHANGES; k++)
+		world_set_block(&batched, changes[k].x, changes[k].y, changes[k].z,
+						changes[k].blk, true);
+
+	do {
+		world_update_lighting(&batched);
+	} while(batched.lighting_stats.pending > 0);
+
+	assert(batched.lighting_stats.updated + batched.lighting_stats.coalesced
+		   == CHANGES);
+
+	for(size_t k = 0; k < CHANGES; k++) {
+		world_set_block(&sequential, changes[k].x, changes[k].y, changes[k].z,
+						changes[k].blk, false);
+		lighting_update_at_block(changes[k], false, get_block, set_light,
+								 &sequential);
+	}
+
+	compare();
+	world_destroy(&batched);
+	world_destroy(&sequential);
+}
+
+int main(void) {
+	blocks_init();
+	chunk_pool_init(0);
+
+	for(unsigned seed = 0; seed < 4; seed++) {
+		// tiny budget for batches of one or two, a large one for full batches
+		run(seed, 1);
+		run(seed, 1000000);
+	}
+
+	return 0;
+}
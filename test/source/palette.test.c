@@ -0,0 +1,103 @@
+/*
+	Copyright (c) 2025 Lunna5
+
+	This file is part of CavEX.
+
+	CavEX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	CavEX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with CavEX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "../../source/palette.h"
+
+#include <assert.h>
+#include <stdlib.h>
+
+static uint16_t expected[PALETTE_LENGTH];
+
+static void check(struct palette* p) {
+	uint16_t actual[PALETTE_LENGTH];
+	palette_get_range(p, 0, PALETTE_LENGTH, actual);
+
+	for(size_t k = 0; k < PALETTE_LENGTH; k++) {
+		assert(palette_get(p, k) == expected[k]);
+		assert(actual[k] == expected[k]);
+	}
+}
+
+static void fill_random(struct palette* p, unsigned seed, size_t distinct) {
+	srand(seed);
+
+	for(size_t k = 0; k < PALETTE_LENGTH * 2; k++) {
+		size_t idx = rand() % PALETTE_LENGTH;
+		expected[idx] = (rand() % distinct) * 37;
+		palette_set(p, idx, expected[idx]);
+	}
+
+	check(p);
+}
+
+int main(void) {
+	palette_pool_init();
+
+	struct palette p;
+	palette_init(&p, 5);
+
+	for(size_t k = 0; k < PALETTE_LENGTH; k++)
+		expected[k] = 5;
+
+	check(&p);
+	assert(p.bits == 0 && palette_bytes(&p) == 0);
+
+	size_t sizes[] = {2, 3, 4, 16, 17, 200, 256, 1000};
+	for(size_t k = 0; k < sizeof(sizes) / sizeof(*sizes); k++)
+		fill_random(&p, k, sizes[k]);
+
+	assert(p.bits == 16);
+
+	// going back to a few values shrinks the storage on the next growth
+	for(size_t k = 0; k < PALETTE_LENGTH; k++) {
+		expected[k] = k % 2;
+		palette_set(&p, k, expected[k]);
+	}
+
+	palette_destroy(&p);
+	palette_init(&p, 0);
+
+	for(size_t k = 0; k < PALETTE_LENGTH; k++) {
+		expected[k] = (k % 3 == 0) ? 7 : 0;
+		palette_set(&p, k, expected[k]);
+	}
+
+	check(&p);
+	assert(p.bits == 1 && p.length == 2);
+
+	expected[100] = 9;
+	palette_set(&p, 100, 9);
+	check(&p);
+	assert(p.bits == 2 && p.length == 3);
+
+	// changes to a copy leave the original alone
+	struct palette copy;
+	palette_copy(&copy, &p);
+	palette_set(&copy, 100, 0);
+	palette_set(&copy, 200, 1);
+	check(&p);
+	assert(palette_get(&copy, 100) == 0 && palette_get(&copy, 200) == 1);
+	palette_destroy(&copy);
+
+	palette_destroy(&p);
+
+	struct pool_stats stats;
+	palette_get_pool_stats(&stats);
+	assert(stats.in_use == 0 && stats.hits > 0);
+	return 0;
+}
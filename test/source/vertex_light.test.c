@@ -0,0 +1,73 @@
+/*
+	Copyright (c) 2025 Lunna5
+
+	This file is part of CavEX.
+
+	CavEX is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	CavEX is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with CavEX.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "../../source/log/log.h"
+#include "../../source/platform/time.h"
+#include "../../source/vertex_light.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PLANE (VERTEX_LIGHT_VOLUME + VERTEX_LIGHT_PADDING)
+#define RUNS 2000
+
+static uint8_t input[PLANE * 3];
+static uint8_t expected[VERTEX_LIGHT_VOLUME * 3];
+static uint8_t actual[VERTEX_LIGHT_VOLUME * 3];
+
+static void fill_random(unsigned seed) {
+	srand(seed);
+	memset(input, 0, sizeof(input));
+
+	for(size_t k = 0; k < VERTEX_LIGHT_VOLUME; k++) {
+		uint8_t pass = (rand() % 3) > 0;
+		input[k] = pass;
+		input[PLANE + k] = pass ? rand() % 16 : 0;
+		input[PLANE * 2 + k] = pass ? rand() % 16 : 0;
+	}
+}
+
+static float benchmark(void (*f)(const uint8_t*, const uint8_t*,
+								 const uint8_t*, uint8_t*)) {
+	ptime_t start = time_get();
+
+	for(int k = 0; k < RUNS; k++)
+		f(input, input + PLANE, input + PLANE * 2, actual);
+
+	return time_diff_s(start, time_get()) * 1e6F / RUNS;
+}
+
+int main(void) {
+	log_set_level(LOG_DEBUG);
+
+	for(unsigned seed = 0; seed < 16; seed++) {
+		fill_random(seed);
+		vertex_light_compute_scalar(input, input + PLANE, input + PLANE * 2,
+									expected);
+		vertex_light_compute(input, input + PLANE, input + PLANE * 2, actual);
+		assert(memcmp(expected, actual, sizeof(actual)) == 0);
+	}
+
+	float scalar = benchmark(vertex_light_compute_scalar);
+	float simd = benchmark(vertex_light_compute);
+	log_debug("vertex light per chunk: scalar %.1fus, simd %.1fus", scalar,
+			  simd);
+
+	return 0;
+}